@@ -12,6 +12,8 @@
 UBTTask_FindNearestPoly::UBTTask_FindNearestPoly(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
+	NodeName = "Find Nearest Poly";
+	BlackboardKey.AddVectorFilter(this, GET_MEMBER_NAME_CHECKED(UBTTask_FindNearestPoly, BlackboardKey));
 }
 
 EBTNodeResult::Type UBTTask_FindNearestPoly::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
@@ -23,33 +25,14 @@ EBTNodeResult::Type UBTTask_FindNearestPoly::ExecuteTask(UBehaviorTreeComponent&
 		return EBTNodeResult::Failed;
 	}
 
-	AShooterGameMode* GameMode = MyBot->GetWorld()->GetAuthGameMode<AShooterGameMode>();
-	if (GameMode == NULL)
-	{
-		return EBTNodeResult::Failed;
-	}
-
-	const FNavAgentProperties* AgentProperties = MyBot->GetNavAgentProperties();
-
-	if (!AgentProperties)
+	// Tracked from the poly of the previous lookup, the box query is only done when the bot left it
+	FNavLocation NavLocation;
+	if (!MyController->UpdateNavLocation(NavLocation))
 	{
 		return EBTNodeResult::Failed;
 	}
 
-	UNavigationSystem* NavSys = GetWorld()->GetNavigationSystem();
-	if (!NavSys) {
-		return EBTNodeResult::Failed;
-	}
-
-	//FNavigationSystem::ECreateIfEmpty CreateNewIfNoneFound;
-	const ANavigationData* NavData = NavSys->GetMainNavData(FNavigationSystem::DontCreate);
-
-	//const ANavigationData* NavData = (AgentProperties != NULL) ? GetNavDataForProps(*AgentProperties) : GetMainNavData(FNavigationSystem::DontCreate);
-	const ARecastNavMesh* NavMesh = Cast<ARecastNavMesh>(NavData);
-	const AMyRecastNavMesh* MyNavMesh = Cast<AMyRecastNavMesh>(NavMesh);
-
-	//MyNavMesh->UpdateNavMesh();
-	//OwnerComp.GetBlackboardComponent()->SetValue<UBlackboardKeyType_Vector>(BlackboardKey.GetSelectedKeyID(), true);
+	OwnerComp.GetBlackboardComponent()->SetValue<UBlackboardKeyType_Vector>(BlackboardKey.GetSelectedKeyID(), NavLocation.Location);
 	return EBTNodeResult::Succeeded;
 }
 
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Bots/PatrolRouteComponent.h"
+
+UPatrolRouteComponent::UPatrolRouteComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	PrimaryComponentTick.bCanEverTick = false;
+	NextWaypointIndex = 0;
+}
+
+void UPatrolRouteComponent::CollectWaypoints(const APawn* Pawn) {
+	Reset();
+	if (!Pawn) {
+		return;
+	}
+
+	TArray<AActor*> AttachedActors;
+	Pawn->GetAttachedActors(AttachedActors);
+	for (auto It = AttachedActors.CreateConstIterator(); It; ++It) {
+		if ((*It)->GetName().Contains("Patrol")) {
+			Waypoints.Add((*It)->GetActorLocation());
+		}
+	}
+	FindLegPaths();
+}
+
+void UPatrolRouteComponent::Reset() {
+	Waypoints.Reset();
+	LegPaths.Reset();
+	NextWaypointIndex = 0;
+}
+
+void UPatrolRouteComponent::FindLegPaths() {
+	UNavigationSystem* NavSys = GetWorld() ? GetWorld()->GetNavigationSystem() : NULL;
+	const ANavigationData* NavData = NavSys ? NavSys->GetMainNavData(FNavigationSystem::DontCreate) : NULL;
+	if (!NavData || Waypoints.Num() < 2) {
+		return;
+	}
+
+	for (int32 Index = 0; Index < Waypoints.Num(); ++Index) {
+		// Owned by the route (not the controller), so they do not go through the planner of the bot
+		FPathFindingQuery Query(this, *NavData, Waypoints[Index], Waypoints[(Index + 1) % Waypoints.Num()], NavData->GetDefaultQueryFilter());
+		const FPathFindingResult Result = NavSys->FindPathSync(Query);
+		FNavPathSharedPtr LegPath = NULL;
+		if (Result.IsSuccessful() && !Result.IsPartial() && Result.Path.IsValid()) {
+			LegPath = Result.Path;
+			// Repathed by the navigation system when the navmesh changes under it
+			LegPath->EnableRecalculationOnInvalidation(true);
+		}
+		LegPaths.Add(LegPath);
+	}
+}
+
+int32 UPatrolRouteComponent::GetNumWaypoints() const {
+	return Waypoints.Num();
+}
+
+bool UPatrolRouteComponent::GetNextWaypoint(FVector& OutWaypoint) {
+	if (Waypoints.Num() == 0) {
+		return false;
+	}
+	if (NextWaypointIndex >= Waypoints.Num()) {
+		NextWaypointIndex = 0;
+	}
+	OutWaypoint = Waypoints[NextWaypointIndex];
+	++NextWaypointIndex;
+	return true;
+}
+
+FNavPathSharedPtr UPatrolRouteComponent::GetLegPath(const FVector Start, const FVector End) const {
+	for (int32 Index = 0; Index < LegPaths.Num(); ++Index) {
+		const FNavPathSharedPtr& LegPath = LegPaths[Index];
+		if (!LegPath.IsValid() || !LegPath->IsValid() || !LegPath->IsUpToDate() || LegPath->GetPathPoints().Num() < 2) {
+			continue;
+		}
+		const FVector LegStart = LegPath->GetPathPoints()[0].Location;
+		const FVector LegEnd = LegPath->GetPathPoints().Last().Location;
+		if (FVector2D::DistSquared(FVector2D(LegEnd), FVector2D(End)) <= FMath::Square(LEG_END_TOLERANCE) && FVector2D::DistSquared(FVector2D(LegStart), FVector2D(Start)) <= FMath::Square(LEG_START_TOLERANCE)) {
+			return LegPath;
+		}
+	}
+	return NULL;
+}
@@ -3,6 +3,7 @@
 #include "ShooterGame.h"
 #include "Bots/ShooterAIController.h"
 #include "Bots/ShooterBot.h"
+#include "Bots/PatrolRouteComponent.h"
 #include "Online/ShooterPlayerState.h"
 #include "BehaviorTree/BehaviorTree.h"
 #include "BehaviorTree/BehaviorTreeComponent.h"
@@ -12,6 +13,7 @@
 #include "Weapons/ShooterWeapon.h"
 #include "Navigation/CrowdFollowingComponent.h"
 #include "Public/Others/HelperMethods.h"
+#include "Public/Others/PlayerVisibilitySnapshot.h"
 #include "Public/EQS/CoverBaseClass.h"
 #include "Perception/AISense_Sight.h"
 #include "Perception/AISense_Hearing.h"
@@ -26,6 +28,8 @@ AShooterAIController::AShooterAIController(const FObjectInitializer& ObjectIniti
  	BlackboardComp = ObjectInitializer.CreateDefaultSubobject<UBlackboardComponent>(this, TEXT("BlackBoardComp"));
  	
 	BrainComponent = BehaviorComp = ObjectInitializer.CreateDefaultSubobject<UBehaviorTreeComponent>(this, TEXT("BehaviorComp"));	
+
+	PatrolRoute = ObjectInitializer.CreateDefaultSubobject<UPatrolRouteComponent>(this, TEXT("PatrolRoute"));
 	
 	// Setup AIPerception component
 	AIPerceptionComp = CreateDefaultSubobject<UAIPerceptionComponent>(TEXT("AIPerception Component"));
@@ -63,6 +67,8 @@ void AShooterAIController::Possess(APawn* InPawn)
 	UAIPerceptionSystem::RegisterPerceptionStimuliSource(this, UAISense_Sight::StaticClass(), InPawn);
 	UAIPerceptionSystem::RegisterPerceptionStimuliSource(this, UAISense_Hearing::StaticClass(), InPawn);
 
+	PatrolRoute->CollectWaypoints(InPawn);
+
 	// Start behavior tree
 	if (Bot && Bot->BotBehavior)
 	{
@@ -85,6 +91,26 @@ void AShooterAIController::Possess(APawn* InPawn)
 
 }
 
+void AShooterAIController::UnPossess()
+{
+	// Dead or gone bots stop counting as observers, and nobody waits for their queued path anymore
+	AMyRecastNavMesh* NavMesh = HelperMethods::GetNavMesh(GetWorld());
+	APawn* OldPawn = GetPawn();
+	if (OldPawn) {
+		if (GetAI_PredictionMap()) {
+			GetAI_PredictionMap()->RemoveBotVisibility(OldPawn->GetName());
+		}
+		if (NavMesh) {
+			NavMesh->RemoveObserverCoverage(OldPawn);
+		}
+	}
+	if (NavMesh) {
+		NavMesh->GetPathRequestQueue().Cancel(this);
+	}
+
+	Super::UnPossess();
+}
+
 void AShooterAIController::BeginInactiveState()
 {
 	Super::BeginInactiveState();
@@ -185,6 +211,65 @@ void AShooterAIController::UpdateControlRotation(float DeltaTime, bool bUpdatePa
 	}
 }
 
+FAIRequestID AShooterAIController::RequestPathAndMove(const FAIMoveRequest& MoveRequest, FPathFindingQuery& Query)
+{
+	// The path following stops waiting for the queued path of the previous move
+	AMyRecastNavMesh* MyNavMesh = HelperMethods::GetNavMesh(GetWorld());
+	if (MyNavMesh)
+	{
+		MyNavMesh->GetPathRequestQueue().Cancel(this);
+	}
+
+	// Patrol legs are already path found
+	const FNavPathSharedPtr LegPath = MoveRequest.IsUsingPathfinding() && !MoveRequest.HasGoalActor() ? PatrolRoute->GetLegPath(Query.StartLocation, Query.EndLocation) : NULL;
+	if (LegPath.IsValid())
+	{
+		return RequestMove(MoveRequest, LegPath);
+	}
+
+	if (!PATH_REQUEST_QUEUE || !MyNavMesh || !MoveRequest.IsUsingPathfinding() || Query.NavData.Get() != MyNavMesh)
+	{
+		return Super::RequestPathAndMove(MoveRequest, Query);
+	}
+
+	// The path following waits for this path, the queue fills it when its turn comes
+	FNavPathSharedPtr Path = MakeShareable(new FNavMeshPath());
+	Path->SetNavigationDataUsed(MyNavMesh);
+	Path->SetQuerier(this);
+	if (MoveRequest.HasGoalActor())
+	{
+		Path->SetGoalActorObservation(*MoveRequest.GetGoalActor(), 100.0f);
+	}
+	Path->EnableRecalculationOnInvalidation(true);
+	Query.PathInstanceToFill = Path;
+
+	// The tracker and the planner are game thread only: short moves are repaired here, the workers get the start poly
+	FNavLocation TrackedStart;
+	const NavNodeRef StartPoly = NavPolyTracker.FindNearby(MyNavMesh, Query.StartLocation, TrackedStart) ? TrackedStart.NodeRef : MyNavMesh->GetFlowFieldPoly(Query.StartLocation);
+	FPathFindingResult IncrementalResult;
+	if (MyNavMesh->FindIncrementalPath(Query, StartPoly, IncrementalResult))
+	{
+		return RequestMove(MoveRequest, IncrementalResult.Path);
+	}
+
+	const FAIRequestID RequestID = RequestMove(MoveRequest, Path);
+	if (RequestID.IsValid())
+	{
+		MyNavMesh->GetPathRequestQueue().Enqueue(this, GetNavAgentPropertiesRef(), Query, StartPoly, GetPathRequestPriority());
+	}
+	return RequestID;
+}
+
+void AShooterAIController::StopMovement()
+{
+	AMyRecastNavMesh* MyNavMesh = HelperMethods::GetNavMesh(GetWorld());
+	if (MyNavMesh)
+	{
+		MyNavMesh->GetPathRequestQueue().Cancel(this);
+	}
+	Super::StopMovement();
+}
+
 void AShooterAIController::GetActorEyesViewPoint(FVector & OutLocation, FRotator & OutRotation) const
 {
 	if (this->GetPawn()) {
@@ -224,6 +309,17 @@ void AShooterAIController::GameHasEnded(AActor* EndGameFocus, bool bIsWinner)
 
 /************************* GENERAL **************************/
 
+int32 AShooterAIController::GetPathRequestPriority() const {
+	switch (GetAI_State()) {
+	case State::VE_Fight:
+		return 2;
+	case State::VE_Search:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
 State AShooterAIController::GetAI_State() const {
 	return  (State) BlackboardComp->GetValueAsEnum("AI_gState");
 }
@@ -238,32 +334,15 @@ void AShooterAIController::SetAI_State(const State BotState) {
 /************************* PATROL **************************/
 
 void AShooterAIController::SetAI_pNextLocation() {
-	FVector NextPatrolPoint;
-	TArray<AActor*> AttachedActors;
-	TArray<FVector> MyPatrolPoints;
-
-	AShooterBot* Bot = Cast<AShooterBot>(GetPawn());
-	Bot->GetAttachedActors(AttachedActors);
-
-	for (auto ItAttachedActor = AttachedActors.CreateConstIterator(); ItAttachedActor; ++ItAttachedActor) {
-		AActor * AttachedActor = *ItAttachedActor;
-		UE_LOG(LogTemp, Warning, TEXT("PatrolPoint's Name is %s"), *AttachedActor->GetName());
-		if (AttachedActor->GetName().Contains("Patrol")) {
-			MyPatrolPoints.Add(AttachedActor->GetActorLocation());
-		}
+	// Patrol points attached after possess
+	if (PatrolRoute->GetNumWaypoints() == 0) {
+		PatrolRoute->CollectWaypoints(GetPawn());
 	}
 
-	if (MyPatrolPoints.Num() > 0 && CurrentPatrolPointIndex == MyPatrolPoints.Num()) {
-		CurrentPatrolPointIndex = 0;
-		NextPatrolPoint = MyPatrolPoints[CurrentPatrolPointIndex];
-		++CurrentPatrolPointIndex;
-	}
-	else {
-		NextPatrolPoint = MyPatrolPoints[CurrentPatrolPointIndex];
-		++CurrentPatrolPointIndex;
+	FVector NextPatrolPoint;
+	if (PatrolRoute->GetNextWaypoint(NextPatrolPoint)) {
+		BlackboardComp->SetValueAsVector("AI_pNextLocation", NextPatrolPoint);
 	}
-	BlackboardComp->SetValueAsVector("AI_pNextLocation", NextPatrolPoint);
-
 }
 
 
@@ -400,6 +479,12 @@ bool AShooterAIController::GetPL_fIsVisible() const {
 
 void AShooterAIController::SetPL_fIsVisible(const bool IsVisible) {
 	BlackboardComp->SetValueAsBool("PL_fIsVisible", IsVisible);
+	if (IsVisible && GetWorld()) {
+		// Whatever the bots searched before no longer tells where the player is
+		for (TActorIterator<AMyInfluenceMap> It(GetWorld()); It; ++It) {
+			It->ClearSearchedTiles();
+		}
+	}
 }
 
 bool AShooterAIController::GetPL_fLost() const {
@@ -639,10 +724,65 @@ void AShooterAIController::UpdateData(const float DeltaSeconds) {
 }
 
 void AShooterAIController::UpdateOwnData(const float DeltaSeconds) {
+	FNavLocation NavLocation;
+	UpdateNavLocation(NavLocation);
 	UpdateMyVisibility();
 	UpdateBotState();
 	UpdateHealthSituation(DeltaSeconds);
 	UpdateWeaponStats();
+	UpdateCrowdLOD(DeltaSeconds);
+}
+
+bool AShooterAIController::UpdateNavLocation(FNavLocation& OutNavLocation) {
+	const APawn* Bot = GetPawn();
+	if (!Bot) {
+		NavPolyTracker.Reset();
+		return false;
+	}
+	return NavPolyTracker.Update(HelperMethods::GetNavMesh(GetWorld()), Bot->GetActorLocation(), OutNavLocation);
+}
+
+const FNavPolyTracker& AShooterAIController::GetNavPolyTracker() const {
+	return NavPolyTracker;
+}
+
+void AShooterAIController::UpdateCrowdLOD(const float DeltaSeconds) {
+	CrowdLOD_timer += DeltaSeconds;
+	UCrowdFollowingComponent* CrowdFollowing = Cast<UCrowdFollowingComponent>(GetPathFollowingComponent());
+	if (CrowdLOD_timer < CROWD_LOD_FREQ || !CrowdFollowing || !GetPawn()) {
+		return;
+	}
+	CrowdLOD_timer = 0;
+
+	float ClosestHumanDistSq = BIG_NUMBER;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It) {
+		const APawn* Human = (*It)->GetPawn();
+		if (Human) {
+			ClosestHumanDistSq = FMath::Min(ClosestHumanDistSq, FVector::DistSquared(Human->GetActorLocation(), GetPawn()->GetActorLocation()));
+		}
+	}
+
+	// Nobody sees how far bots avoid each other, only the crowd between them
+	const bool bSimulate = ClosestHumanDistSq < FMath::Square(CROWD_LOD_SIMPLE);
+	if (bSimulate != CrowdFollowing->IsCrowdSimulationEnabled()) {
+		// Only switched while idle, it is tried again next update otherwise
+		CrowdFollowing->SetCrowdSimulation(bSimulate);
+	}
+	if (!bSimulate) {
+		return;
+	}
+
+	ECrowdAvoidanceQuality::Type Quality = ECrowdAvoidanceQuality::Low;
+	if (ClosestHumanDistSq < FMath::Square(CROWD_LOD_HIGH)) {
+		Quality = ECrowdAvoidanceQuality::High;
+	}
+	else if (ClosestHumanDistSq < FMath::Square(CROWD_LOD_GOOD)) {
+		Quality = ECrowdAvoidanceQuality::Good;
+	}
+	else if (ClosestHumanDistSq < FMath::Square(CROWD_LOD_MEDIUM)) {
+		Quality = ECrowdAvoidanceQuality::Medium;
+	}
+	CrowdFollowing->SetCrowdAvoidanceQuality(Quality);
 }
 
 void AShooterAIController::UpdatePlayerRelatedData(const float DeltaSeconds) {
@@ -722,7 +862,16 @@ void AShooterAIController::UpdatePlayerLocationAndRotation(const float DeltaSeco
 
 		AMyInfluenceMap * MyInfluenceMap = this->GetAI_PredictionMap();
 		if (MyInfluenceMap) {
-			MyInfluenceMap->SetBotVisibility(Bot->GetName(),HelperMethods::CalculateVisibility(GetWorld(), GetPawn()->GetActorLocation(), GetPawn()->GetActorForwardVector()));
+			MyInfluenceMap->SetBotVisibility(GetPawn()->GetName(), GetPawn()->GetActorLocation(), GetPawn()->GetActorForwardVector());
+
+			// The fan is still needed for the team coverage
+			if (VISIBILITY_ASYNC_TRACES) {
+				HelperMethods::CalculateVisibilityAsync(GetWorld(), GetPawn()->GetActorLocation(), GetPawn()->GetActorForwardVector(), FVisibilityCalculatedDelegate::CreateUObject(this, &AShooterAIController::OnBotVisibilityCalculated));
+			}
+			else {
+				TArray<Triangle> VisibleTriangles = HelperMethods::CalculateVisibility(GetWorld(), GetPawn()->GetActorLocation(), GetPawn()->GetActorForwardVector());
+				OnBotVisibilityCalculated(VisibleTriangles);
+			}
 		}
 
 		//SetPL_fForwardVector(FVector(2, 2, 2));
@@ -770,10 +919,16 @@ void AShooterAIController::UpdateMyVisibility() {
 		const FVector UpMyLocation = FVector(MyLocation.X, MyLocation.Y, HelperMethods::EYES_POS_Z);
 		
 
-		CollisionParams.AddIgnoredActor(BotPawn);
+		bool PlayerIsVisible;
+		if (HelperMethods::GetBakedLineOfSight(World, UpMyLocation, UpPlayerLocation, PlayerIsVisible, true)) {
+			SetPL_fIsVisible(PlayerIsVisible);
+		}
+		else {
+			CollisionParams.AddIgnoredActor(BotPawn);
 
-		const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, UpMyLocation, UpPlayerLocation, ECollisionChannel::ECC_Visibility, CollisionParams);
-		SetPL_fIsVisible(BlockingHitFound && OutHit.Actor->GetName().Contains("Player"));
+			const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, UpMyLocation, UpPlayerLocation, ECollisionChannel::ECC_Visibility, CollisionParams);
+			SetPL_fIsVisible(BlockingHitFound && OutHit.Actor->GetName().Contains("Player"));
+		}
 	}
 	else if (BotPawn) {
 		State a = GetAI_State();
@@ -787,11 +942,17 @@ void AShooterAIController::UpdateMyVisibility() {
 			const FVector UpMyLocation = FVector(MyLocation.X, MyLocation.Y, HelperMethods::EYES_POS_Z);
 
 
-			FCollisionQueryParams CollisionParams;
-			UGameplayStatics::GetAllActorsOfClass(GetWorld(), AShooterCharacter::StaticClass(), ActorsToIgnore);
-			CollisionParams.AddIgnoredActors(ActorsToIgnore);
-			const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, UpMyLocation, PlayerLastLocUp, ECollisionChannel::ECC_Visibility, CollisionParams);
-			SetPL_fLost(!BlockingHitFound);
+			bool LastLocationIsVisible;
+			if (HelperMethods::GetBakedLineOfSight(World, UpMyLocation, PlayerLastLocUp, LastLocationIsVisible, true)) {
+				SetPL_fLost(LastLocationIsVisible);
+			}
+			else {
+				FCollisionQueryParams CollisionParams;
+				UGameplayStatics::GetAllActorsOfClass(GetWorld(), AShooterCharacter::StaticClass(), ActorsToIgnore);
+				CollisionParams.AddIgnoredActors(ActorsToIgnore);
+				const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, UpMyLocation, PlayerLastLocUp, ECollisionChannel::ECC_Visibility, CollisionParams);
+				SetPL_fLost(!BlockingHitFound);
+			}
 		}
 	}
 }
@@ -803,10 +964,8 @@ void AShooterAIController::UpdatePlayerVisibility() {
 		const FVector PlayerLocation = PlayerPawn->GetActorLocation();
 		const FVector PlayerForwardVector = PlayerPawn->GetActorForwardVector();
 
-		const TArray<Triangle> VisibleTriangles = HelperMethods::CalculateVisibility(GetWorld(), PlayerLocation, PlayerForwardVector);
-
-		// Update Navigation Mesh
-		dtQueryFilter_Example::SetPlayerVisibility(VisibleTriangles);
+		// Computed once per frame for all the bots, the snapshot also updates the Navigation Mesh
+		PlayerVisibilitySnapshots::Request(GetWorld(), PlayerPawn, VISIBILITY_ASYNC_TRACES);
 
 		// Check if I am Visible
 		bool IAmVisible = false;
@@ -821,8 +980,7 @@ void AShooterAIController::UpdatePlayerVisibility() {
 	}else {
 		// @todo prediction
 		SetPL_fIamVisible(false);
-		TArray<Triangle> VisibleTriangles;
-		dtQueryFilter_Example::SetPlayerVisibility(VisibleTriangles);
+		PlayerVisibilitySnapshots::Release(GetWorld(), NULL);
 		/*
 		TArray<Triangle> VisibleTriangles;
 		if (GetAI_State() == State::VE_Fight) {
@@ -843,6 +1001,17 @@ void AShooterAIController::UpdatePlayerVisibility() {
 	}
 }
 
+void AShooterAIController::OnBotVisibilityCalculated(TArray<Triangle>& VisibleTriangles) {
+	const AShooterBot* Bot = Cast<AShooterBot>(GetPawn());
+
+	// Update team coverage
+	AMyRecastNavMesh* NavMesh = HelperMethods::GetNavMesh(GetWorld());
+	if (Bot && NavMesh) {
+		BotVisibilityFan.Build(VisibleTriangles);
+		NavMesh->UpdateObserverCoverage(Bot, BotVisibilityFan);
+	}
+}
+
 void AShooterAIController::UpdateTacticalCoverSituation() {
 	bool NextCoverIsSafe = true;
 	bool CurrentCoverIsSafe = true;
@@ -935,7 +1104,19 @@ bool AShooterAIController::PositionIsSafeCover(const FVector CoverPosition, cons
 		return PositionIsSafeCover;
 	}
 
-	// Check Behind obstacle <- Player cant see me
+	const FVector UpPlayerLocation = FVector(PlayerPosition.X, PlayerPosition.Y, HelperMethods::EYES_POS_Z);
+	const FVector UpCoverPosition = FVector(CoverPosition.X, CoverPosition.Y, HelperMethods::EYES_POS_Z);
+
+	// Check Behind obstacle <- Player cant see me. The grid only knows the static collision, a dynamic actor can still hide me
+	if (HelperMethods::GetGridLineOfSight(World, UpCoverPosition, UpPlayerLocation) == ELineOfSight::Blocked) {
+		return true;
+	}
+
+	bool CoverIsVisible;
+	if (HelperMethods::GetBakedLineOfSight(World, CoverPosition, PlayerPosition, CoverIsVisible, true)) {
+		return !CoverIsVisible;
+	}
+
 	FHitResult OutHit;
 	FCollisionQueryParams CollisionParams;
 	TArray<AActor*> ActorsToIgnore;
@@ -943,9 +1124,6 @@ bool AShooterAIController::PositionIsSafeCover(const FVector CoverPosition, cons
 	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AShooterBot::StaticClass(), ActorsToIgnore);
 	CollisionParams.AddIgnoredActors(ActorsToIgnore);
 
-	const FVector UpPlayerLocation = FVector(PlayerPosition.X, PlayerPosition.Y, HelperMethods::EYES_POS_Z);
-	const FVector UpCoverPosition = FVector(CoverPosition.X, CoverPosition.Y, HelperMethods::EYES_POS_Z);
-
 	const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, UpCoverPosition, UpPlayerLocation, ECollisionChannel::ECC_Visibility, CollisionParams);
 
 	if (BlockingHitFound && !OutHit.Actor->GetName().Contains("Player")) {
@@ -1000,8 +1178,17 @@ bool AShooterAIController::PositionIsGoodAttack(const FVector AttackPosition, co
 	if (!GetPL_fIsVisible()) {
 		return PositionIsGoodAttack;
 	}
+
+	// Low cover at the position: the player can't see the crouched body while the bot shoots over it
+	bool BodyIsVisible;
+	bool PlayerIsVisible;
+	if (HelperMethods::GetStanceLineOfSight(World, PlayerPosition, HelperMethods::EYES_POS_Z, AttackPosition, HelperMethods::CROUCHED_EYES_POS_Z, BodyIsVisible) && !BodyIsVisible &&
+		HelperMethods::GetStanceLineOfSight(World, AttackPosition, HelperMethods::EYES_POS_Z, PlayerPosition, HelperMethods::EYES_POS_Z, PlayerIsVisible) && PlayerIsVisible) {
+		return true;
+	}
+
 	// Has Cover Position NEAR (Behind obstacle position)
-	for (float X = AttackPosition.X - 250; X < AttackPosition.X + 250; X += 10) {
+	for (float X = AttackPosition.X - 250; X < AttackPosition.X + 250 && !PositionIsGoodAttack; X += 10) {
 		for (float Y = AttackPosition.Y - 250; Y < AttackPosition.Y + 250; Y += 10) {
 			const FVector CoverPosition = FVector(X, Y, HelperMethods::EYES_POS_Z);
 			//UNavigationSystem::ProjectPointToNavigation()
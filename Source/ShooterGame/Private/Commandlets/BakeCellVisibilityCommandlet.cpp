@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "AssetRegistryModule.h"
+#include "Public/Navigation/MyRecastNavMesh.h"
+#include "Public/Others/HelperMethods.h"
+#include "Public/Others/CellVisibilityData.h"
+#include "Public/Commandlets/BakeCellVisibilityCommandlet.h"
+
+UBakeCellVisibilityCommandlet::UBakeCellVisibilityCommandlet(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UBakeCellVisibilityCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString MapName;
+	float CellSize = 100.0f;
+	if (!FParse::Value(*Params, TEXT("Map="), MapName)) {
+		UE_LOG(LogShooter, Error, TEXT("BakeCellVisibility: missing -Map=/Game/Maps/MapName"));
+		return 1;
+	}
+	FParse::Value(*Params, TEXT("CellSize="), CellSize);
+
+	UPackage* MapPackage = LoadPackage(NULL, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : NULL;
+	if (!World) {
+		UE_LOG(LogShooter, Error, TEXT("BakeCellVisibility: could not load map %s"), *MapName);
+		return 1;
+	}
+
+	// Collision needs an initialized world with registered components
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	World->InitWorld();
+	World->UpdateWorldComponents(true, false);
+
+	AMyRecastNavMesh* NavMesh = NULL;
+	for (TActorIterator<AMyRecastNavMesh> It(World); It; ++It) {
+		NavMesh = *It;
+		break;
+	}
+	if (!NavMesh) {
+		UE_LOG(LogShooter, Error, TEXT("BakeCellVisibility: %s has no AMyRecastNavMesh"), *MapName);
+		World->RemoveFromRoot();
+		return 1;
+	}
+
+	const FBox Bounds = NavMesh->GetBounds();
+	UCellVisibilityData* Data = NewObject<UCellVisibilityData>();
+	Data->GridOrigin = FVector2D(Bounds.Min.X, Bounds.Min.Y);
+	Data->CellSize = CellSize;
+	Data->CellsX = FMath::CeilToInt((Bounds.Max.X - Bounds.Min.X) / CellSize);
+	Data->CellsY = FMath::CeilToInt((Bounds.Max.Y - Bounds.Min.Y) / CellSize);
+	Data->CellRows.Init(INDEX_NONE, Data->CellsX * Data->CellsY);
+
+	// Navigable cells get a row
+	TArray<FVector> RowLocations;
+	const FVector ProjectExtent = FVector(CellSize / 2, CellSize / 2, Bounds.Max.Z - Bounds.Min.Z);
+	for (int32 Y = 0; Y < Data->CellsY; ++Y) {
+		for (int32 X = 0; X < Data->CellsX; ++X) {
+			const FVector CellCenter = FVector(Data->GridOrigin.X + (X + 0.5f) * CellSize, Data->GridOrigin.Y + (Y + 0.5f) * CellSize, HelperMethods::EYES_POS_Z);
+			FNavLocation Projected;
+			if (NavMesh->ProjectPoint(CellCenter, Projected, ProjectExtent)) {
+				Data->CellRows[Y * Data->CellsX + X] = RowLocations.Num();
+				RowLocations.Add(CellCenter);
+			}
+		}
+	}
+
+	const int32 NumRows = RowLocations.Num();
+	UE_LOG(LogShooter, Display, TEXT("BakeCellVisibility: %d navigable cells of %d"), NumRows, Data->CellsX * Data->CellsY);
+
+	FCollisionQueryParams CollisionParams;
+	TArray<AActor*> ActorsToIgnore;
+	for (TActorIterator<AShooterCharacter> It(World); It; ++It) {
+		ActorsToIgnore.Add(*It);
+	}
+	CollisionParams.AddIgnoredActors(ActorsToIgnore);
+
+	// Visibility is symmetric, trace each pair once
+	TBitArray<> VisibilityMatrix(false, NumRows * NumRows);
+	for (int32 From = 0; From < NumRows; ++From) {
+		VisibilityMatrix[From * NumRows + From] = true;
+		for (int32 To = From + 1; To < NumRows; ++To) {
+			const bool Visible = !World->LineTraceTestByChannel(RowLocations[From], RowLocations[To], ECollisionChannel::ECC_Visibility, CollisionParams);
+			VisibilityMatrix[From * NumRows + To] = Visible;
+			VisibilityMatrix[To * NumRows + From] = Visible;
+		}
+	}
+	Data->SetVisibility(VisibilityMatrix, NumRows);
+
+	// Save it next to the map
+	const FString PackageName = MapName + UCellVisibilityData::ASSET_SUFFIX;
+	UPackage* Package = CreatePackage(NULL, *PackageName);
+	Data->Rename(*FPackageName::GetShortName(PackageName), Package);
+	Data->SetFlags(RF_Public | RF_Standalone);
+	FAssetRegistryModule::AssetCreated(Data);
+	Package->MarkPackageDirty();
+
+	const FString FileName = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+	const bool Saved = UPackage::SavePackage(Package, Data, RF_Public | RF_Standalone, *FileName);
+	UE_LOG(LogShooter, Display, TEXT("BakeCellVisibility: %d runs for %d rows saved to %s"), Data->Runs.Num(), NumRows, *FileName);
+
+	World->RemoveFromRoot();
+	return Saved ? 0 : 1;
+#else
+	return 1;
+#endif // WITH_EDITOR
+}
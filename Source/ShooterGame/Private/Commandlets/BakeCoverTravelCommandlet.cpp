@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "AssetRegistryModule.h"
+#include "Public/Navigation/MyRecastNavMesh.h"
+#include "Public/Navigation/NavFlowField.h"
+#include "Public/EQS/CoverBaseClass.h"
+#include "Public/Others/CoverTravelData.h"
+#include "Public/Commandlets/BakeCoverTravelCommandlet.h"
+
+UBakeCoverTravelCommandlet::UBakeCoverTravelCommandlet(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UBakeCoverTravelCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString MapName;
+	float Spacing = 1000.0f;
+	float WalkSpeed = 600.0f;
+	if (!FParse::Value(*Params, TEXT("Map="), MapName)) {
+		UE_LOG(LogShooter, Error, TEXT("BakeCoverTravel: missing -Map=/Game/Maps/MapName"));
+		return 1;
+	}
+	FParse::Value(*Params, TEXT("Spacing="), Spacing);
+	FParse::Value(*Params, TEXT("WalkSpeed="), WalkSpeed);
+
+	UPackage* MapPackage = LoadPackage(NULL, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : NULL;
+	if (!World) {
+		UE_LOG(LogShooter, Error, TEXT("BakeCoverTravel: could not load map %s"), *MapName);
+		return 1;
+	}
+
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	World->InitWorld();
+	World->UpdateWorldComponents(true, false);
+
+	AMyRecastNavMesh* NavMesh = NULL;
+	for (TActorIterator<AMyRecastNavMesh> It(World); It; ++It) {
+		NavMesh = *It;
+		break;
+	}
+	if (!NavMesh || !NavMesh->GetRecastMesh()) {
+		UE_LOG(LogShooter, Error, TEXT("BakeCoverTravel: %s has no AMyRecastNavMesh"), *MapName);
+		World->RemoveFromRoot();
+		return 1;
+	}
+
+	UCoverTravelData* Data = NewObject<UCoverTravelData>();
+	Data->WalkSpeed = WalkSpeed;
+
+	// Cover annotations, then the navmesh points of the grid
+	for (TActorIterator<ACoverBaseClass> It(World); It; ++It) {
+		TArray<AActor*> CoverAnnotations;
+		It->GetAttachedActors(CoverAnnotations);
+		for (auto It2 = CoverAnnotations.CreateConstIterator(); It2; ++It2) {
+			Data->Waypoints.Add((*It2)->GetActorLocation());
+		}
+	}
+	Data->NumCovers = Data->Waypoints.Num();
+
+	const FBox Bounds = NavMesh->GetBounds();
+	const FVector ProjectExtent = FVector(Spacing / 2, Spacing / 2, Bounds.Max.Z - Bounds.Min.Z);
+	for (float Y = Bounds.Min.Y + Spacing / 2; Y < Bounds.Max.Y; Y += Spacing) {
+		for (float X = Bounds.Min.X + Spacing / 2; X < Bounds.Max.X; X += Spacing) {
+			FNavLocation Projected;
+			if (NavMesh->ProjectPoint(FVector(X, Y, Bounds.GetCenter().Z), Projected, ProjectExtent)) {
+				Data->Waypoints.Add(Projected.Location);
+			}
+		}
+	}
+
+	const int32 NumWaypoints = Data->Waypoints.Num();
+	UE_LOG(LogShooter, Display, TEXT("BakeCoverTravel: %d cover annotations and %d navmesh points"), Data->NumCovers, NumWaypoints - Data->NumCovers);
+
+	TArray<dtPolyRef> WaypointPolys;
+	for (int32 Index = 0; Index < NumWaypoints; ++Index) {
+		WaypointPolys.Add(NavMesh->GetFlowFieldPoly(Data->Waypoints[Index]));
+	}
+
+	// Path lengths with the stock detour costs (the threats are not known offline), one flow field per waypoint
+	const TSharedPtr<const dtQueryFilter> Filter = MakeShareable(new dtQueryFilter(false));
+	TArray<float> Times;
+	Times.Init(BIG_NUMBER, NumWaypoints * NumWaypoints);
+	for (int32 From = 0; From < NumWaypoints; ++From) {
+		if (!WaypointPolys[From]) {
+			continue;
+		}
+		FNavFlowField FlowField(WaypointPolys[From], Data->Waypoints[From], 0);
+		FlowField.Build(NavMesh->GetRecastMesh(), Filter);
+		for (int32 To = 0; To < NumWaypoints; ++To) {
+			if (WaypointPolys[To] && FlowField.IsReachable(WaypointPolys[To])) {
+				Times[From * NumWaypoints + To] = FlowField.GetLength(WaypointPolys[To], Data->Waypoints[To]) / WalkSpeed;
+			}
+		}
+	}
+	Data->SetTravelTimes(Times);
+
+	// Save it next to the map
+	const FString PackageName = MapName + UCoverTravelData::ASSET_SUFFIX;
+	UPackage* Package = CreatePackage(NULL, *PackageName);
+	Data->Rename(*FPackageName::GetShortName(PackageName), Package);
+	Data->SetFlags(RF_Public | RF_Standalone);
+	FAssetRegistryModule::AssetCreated(Data);
+	Package->MarkPackageDirty();
+
+	const FString FileName = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+	const bool Saved = UPackage::SavePackage(Package, Data, RF_Public | RF_Standalone, *FileName);
+	UE_LOG(LogShooter, Display, TEXT("BakeCoverTravel: %d x %d travel times (%.3f s step) saved to %s"), NumWaypoints, NumWaypoints, Data->TimeStep, *FileName);
+
+	World->RemoveFromRoot();
+	return Saved ? 0 : 1;
+#else
+	return 1;
+#endif // WITH_EDITOR
+}
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "AI/Navigation/RecastNavMesh.h"
+#include "Public/Navigation/NavTileBlob.h"
+#include "Public/Commandlets/BakeNavTilesCommandlet.h"
+
+UBakeNavTilesCommandlet::UBakeNavTilesCommandlet(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UBakeNavTilesCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString MapName;
+	if (!FParse::Value(*Params, TEXT("Map="), MapName)) {
+		UE_LOG(LogShooter, Error, TEXT("BakeNavTiles: missing -Map=/Game/Maps/MapName"));
+		return 1;
+	}
+
+	UPackage* MapPackage = LoadPackage(NULL, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : NULL;
+	if (!World) {
+		UE_LOG(LogShooter, Error, TEXT("BakeNavTiles: could not load map %s"), *MapName);
+		return 1;
+	}
+
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	World->InitWorld();
+	World->UpdateWorldComponents(true, false);
+
+	// Tiles as saved in the level
+	const ARecastNavMesh* NavMesh = NULL;
+	for (TActorIterator<ARecastNavMesh> It(World); It && !NavMesh; ++It) {
+		NavMesh = *It;
+	}
+	const dtNavMesh* DetourMesh = NavMesh ? NavMesh->GetRecastMesh() : NULL;
+	if (!DetourMesh) {
+		UE_LOG(LogShooter, Error, TEXT("BakeNavTiles: %s has no built navmesh"), *MapName);
+		World->RemoveFromRoot();
+		return 1;
+	}
+
+	const FString FileName = FNavTileBlob::GetFileName(World);
+	const bool Saved = FNavTileBlob::Write(FileName, DetourMesh);
+	UE_LOG(LogShooter, Display, TEXT("BakeNavTiles: saved to %s"), *FileName);
+
+	World->RemoveFromRoot();
+	return Saved ? 0 : 1;
+#else
+	return 1;
+#endif // WITH_EDITOR
+}
@@ -0,0 +1,242 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "AssetRegistryModule.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "Engine/Polys.h"
+#include "Public/EQS/CoverBaseClass.h"
+#include "Public/Others/OccluderSegmentData.h"
+#include "Public/Commandlets/BakeOccludersCommandlet.h"
+
+UBakeOccludersCommandlet::UBakeOccludersCommandlet(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+#if WITH_EDITOR
+
+// Counter clockwise convex hull (monotone chain)
+static TArray<FVector2D> GetConvexHull(TArray<FVector2D> Points) {
+	Points.Sort([](const FVector2D &A, const FVector2D &B) {
+		return A.X < B.X || (A.X == B.X && A.Y < B.Y);
+	});
+
+	TArray<FVector2D> Hull;
+	if (Points.Num() < 3) {
+		return Points;
+	}
+
+	// Lower hull, then upper hull
+	for (int32 Pass = 0; Pass < 2; ++Pass) {
+		const int32 HullStart = Hull.Num();
+		for (int32 Index = 0; Index < Points.Num(); ++Index) {
+			const FVector2D& Point = Points[Pass == 0 ? Index : Points.Num() - 1 - Index];
+			while (Hull.Num() >= HullStart + 2 && FVector2D::CrossProduct(Hull.Last() - Hull.Last(1), Point - Hull.Last(1)) <= 0) {
+				Hull.Pop(false);
+			}
+			Hull.Add(Point);
+		}
+		// Last point is the first of the next pass
+		Hull.Pop(false);
+	}
+	return Hull;
+}
+
+static void AddElementPoints(const FTransform& ElementToWorld, const TArray<FVector>& LocalPoints, TArray<TArray<FVector>>& OutElements) {
+	TArray<FVector>& WorldPoints = OutElements[OutElements.AddDefaulted()];
+	for (auto It = LocalPoints.CreateConstIterator(); It; ++It) {
+		WorldPoints.Add(ElementToWorld.TransformPosition(*It));
+	}
+}
+
+// Ring of points around the local Z axis at height Z
+static void AddRing(TArray<FVector>& OutPoints, const float Radius, const float Z) {
+	const int32 RingPoints = 8;
+	for (int32 Index = 0; Index < RingPoints; ++Index) {
+		const float Angle = 2 * PI * Index / RingPoints;
+		OutPoints.Add(FVector(Radius * FMath::Cos(Angle), Radius * FMath::Sin(Angle), Z));
+	}
+}
+
+// World space points of every simple collision element of the component. Complex only collision adds none
+static void GetCollisionElements(const UPrimitiveComponent* Component, TArray<TArray<FVector>>& OutElements) {
+	const FTransform& ComponentToWorld = Component->ComponentToWorld;
+	UBodySetup* BodySetup = const_cast<UPrimitiveComponent*>(Component)->GetBodySetup();
+
+	if (BodySetup) {
+		const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+		for (auto It = AggGeom.BoxElems.CreateConstIterator(); It; ++It) {
+			TArray<FVector> Corners;
+			for (int32 Corner = 0; Corner < 8; ++Corner) {
+				Corners.Add(FVector((Corner & 1) ? It->X : -It->X, (Corner & 2) ? It->Y : -It->Y, (Corner & 4) ? It->Z : -It->Z) * 0.5f);
+			}
+			AddElementPoints(It->GetTransform() * ComponentToWorld, Corners, OutElements);
+		}
+		for (auto It = AggGeom.SphereElems.CreateConstIterator(); It; ++It) {
+			TArray<FVector> SpherePoints;
+			AddRing(SpherePoints, It->Radius, 0);
+			SpherePoints.Add(FVector(0, 0, It->Radius));
+			SpherePoints.Add(FVector(0, 0, -It->Radius));
+			AddElementPoints(FTransform(It->Center) * ComponentToWorld, SpherePoints, OutElements);
+		}
+		for (auto It = AggGeom.SphylElems.CreateConstIterator(); It; ++It) {
+			TArray<FVector> CapsulePoints;
+			AddRing(CapsulePoints, It->Radius, It->Length * 0.5f);
+			AddRing(CapsulePoints, It->Radius, -It->Length * 0.5f);
+			CapsulePoints.Add(FVector(0, 0, It->Length * 0.5f + It->Radius));
+			CapsulePoints.Add(FVector(0, 0, -It->Length * 0.5f - It->Radius));
+			AddElementPoints(It->GetTransform() * ComponentToWorld, CapsulePoints, OutElements);
+		}
+		for (auto It = AggGeom.ConvexElems.CreateConstIterator(); It; ++It) {
+			AddElementPoints(It->GetTransform() * ComponentToWorld, It->VertexData, OutElements);
+		}
+	}
+}
+
+// Corners of the axis aligned bounds of the actor, what the fans used for it before the bake
+static void GetBoundsElement(const AActor* Actor, TArray<TArray<FVector>>& OutElements) {
+	FVector Origin;
+	FVector BoundsExtent;
+	Actor->GetActorBounds(false, Origin, BoundsExtent);
+
+	TArray<FVector> Corners;
+	for (int32 Corner = 0; Corner < 8; ++Corner) {
+		Corners.Add(FVector((Corner & 1) ? BoundsExtent.X : -BoundsExtent.X, (Corner & 2) ? BoundsExtent.Y : -BoundsExtent.Y, (Corner & 4) ? BoundsExtent.Z : -BoundsExtent.Z));
+	}
+	AddElementPoints(FTransform(Origin), Corners, OutElements);
+}
+
+// BSP geometry has no actor components to iterate, additive brushes are convex so their polygons make one element
+static void GetBrushElement(const ABrush* Brush, TArray<TArray<FVector>>& OutElements) {
+	if (Brush->IsA(AVolume::StaticClass()) || Brush->BrushType != Brush_Add || !Brush->Brush || !Brush->Brush->Polys) {
+		return;
+	}
+
+	TArray<FVector> BrushPoints;
+	for (auto It = Brush->Brush->Polys->Element.CreateConstIterator(); It; ++It) {
+		for (auto ItVertex = It->Vertices.CreateConstIterator(); ItVertex; ++ItVertex) {
+			BrushPoints.Add(*ItVertex);
+		}
+	}
+	if (BrushPoints.Num() > 0) {
+		AddElementPoints(Brush->ActorToWorld(), BrushPoints, OutElements);
+	}
+}
+
+static void AddElementLoops(UOccluderSegmentData* Data, const TArray<TArray<FVector>>& Elements, const float MinHeight) {
+	for (auto ItElement = Elements.CreateConstIterator(); ItElement; ++ItElement) {
+		const FBox ElementBox(*ItElement);
+		if (ElementBox.Max.Z - ElementBox.Min.Z < MinHeight) {
+			continue;
+		}
+
+		TArray<FVector2D> Footprint;
+		for (auto ItPoint = ItElement->CreateConstIterator(); ItPoint; ++ItPoint) {
+			Footprint.Add(FVector2D(ItPoint->X, ItPoint->Y));
+		}
+		Data->AddLoop(GetConvexHull(Footprint), ElementBox.Min.Z, ElementBox.Max.Z);
+	}
+}
+
+#endif // WITH_EDITOR
+
+int32 UBakeOccludersCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString MapName;
+	// Shorter collision (curbs, stairs) is not worth as occluder
+	float MinHeight = 50.0f;
+	if (!FParse::Value(*Params, TEXT("Map="), MapName)) {
+		UE_LOG(LogShooter, Error, TEXT("BakeOccluders: missing -Map=/Game/Maps/MapName"));
+		return 1;
+	}
+	FParse::Value(*Params, TEXT("MinHeight="), MinHeight);
+
+	UPackage* MapPackage = LoadPackage(NULL, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : NULL;
+	if (!World) {
+		UE_LOG(LogShooter, Error, TEXT("BakeOccluders: could not load map %s"), *MapName);
+		return 1;
+	}
+
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	World->InitWorld();
+	World->UpdateWorldComponents(true, false);
+
+	UOccluderSegmentData* Data = NewObject<UOccluderSegmentData>();
+	int32 NumComponents = 0;
+	int32 NumSkipped = 0;
+
+	for (TActorIterator<AActor> It(World); It; ++It) {
+		const AActor* Actor = *It;
+		if (Actor->IsA(APawn::StaticClass())) {
+			continue;
+		}
+
+		// Cover is placed to block the view whatever its collision setup is
+		if (Actor->IsA(ACoverBaseClass::StaticClass())) {
+			TArray<TArray<FVector>> Elements;
+			GetBoundsElement(Actor, Elements);
+			AddElementLoops(Data, Elements, MinHeight);
+			++NumComponents;
+			continue;
+		}
+
+		const ABrush* Brush = Cast<ABrush>(Actor);
+		if (Brush) {
+			TArray<TArray<FVector>> Elements;
+			GetBrushElement(Brush, Elements);
+			AddElementLoops(Data, Elements, MinHeight);
+			NumComponents += Elements.Num();
+			continue;
+		}
+
+		TInlineComponentArray<UPrimitiveComponent*> Components;
+		Actor->GetComponents(Components);
+		for (auto ItComponent = Components.CreateConstIterator(); ItComponent; ++ItComponent) {
+			const UPrimitiveComponent* Component = *ItComponent;
+			// Movable geometry stays where it was placed unless physics or a movement component moves it
+			const bool CanMove = Component->Mobility == EComponentMobility::Movable &&
+				(Component->BodyInstance.bSimulatePhysics || Actor->FindComponentByClass<UMovementComponent>());
+			if (CanMove || !Component->IsCollisionEnabled() ||
+				Component->GetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility) != ECR_Block) {
+				continue;
+			}
+
+			TArray<TArray<FVector>> Elements;
+			GetCollisionElements(Component, Elements);
+			if (Elements.Num() == 0) {
+				// Only complex collision: its bounds would hide whatever is around a concave mesh
+				UE_LOG(LogShooter, Warning, TEXT("BakeOccluders: skipping %s, it has no simple collision"), *Component->GetPathName());
+				++NumSkipped;
+				continue;
+			}
+			AddElementLoops(Data, Elements, MinHeight);
+			++NumComponents;
+		}
+	}
+
+	UE_LOG(LogShooter, Display, TEXT("BakeOccluders: %d loops (%d points) from %d components, %d skipped"), Data->GetNumLoops(), Data->Points.Num(), NumComponents, NumSkipped);
+
+	// Save it next to the map
+	const FString PackageName = MapName + UOccluderSegmentData::ASSET_SUFFIX;
+	UPackage* Package = CreatePackage(NULL, *PackageName);
+	Data->Rename(*FPackageName::GetShortName(PackageName), Package);
+	Data->SetFlags(RF_Public | RF_Standalone);
+	FAssetRegistryModule::AssetCreated(Data);
+	Package->MarkPackageDirty();
+
+	const FString FileName = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+	const bool Saved = UPackage::SavePackage(Package, Data, RF_Public | RF_Standalone, *FileName);
+	UE_LOG(LogShooter, Display, TEXT("BakeOccluders: saved to %s"), *FileName);
+
+	World->RemoveFromRoot();
+	return Saved ? 0 : 1;
+#else
+	return 1;
+#endif // WITH_EDITOR
+}
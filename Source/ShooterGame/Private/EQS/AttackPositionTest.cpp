@@ -6,6 +6,7 @@
 #include "EnvironmentQuery/Items/EnvQueryItemType_VectorBase.h"
 #include "Public/Bots/ShooterAIController.h"
 #include "Public/EQS/CoverBaseClass.h"
+#include "Public/Others/HelperMethods.h"
 #include "Public/EQS/AttackPositionTest.h"
 
 
@@ -40,10 +41,21 @@ void UAttackPositionTest::RunTest(FEnvQueryInstance& QueryInstance) const
 		return;
 	}
 
-	// Get all covers annotations within radius
+	// Cover annotations come from the index of the navmesh, only without one (or an empty one) they are gathered here
 	UWorld * World = GEngine->GetWorldFromContextObject(QueryOwner);
-	const TArray<FVector> LocationOfCoverAnnotations = GetLocationOfCoverAnnotationsWithinRadius(World, ContextLocations[0]);
+	const AMyRecastNavMesh* NavMesh = HelperMethods::GetNavMesh(World);
+	const FCoverAnnotationIndex* CoverAnnotationIndex = NavMesh && NavMesh->GetCoverAnnotations().Num() > 0 ? &NavMesh->GetCoverAnnotations() : NULL;
+	const TArray<FVector> LocationOfCoverAnnotations = CoverAnnotationIndex ? TArray<FVector>() : GetLocationOfCoverAnnotationsWithinRadius(World, ContextLocations[0]);
+	TArray<int32> NearAnnotations;
+
 
+	FCollisionQueryParams CharactersIgnoredParams;
+	FCollisionQueryParams BotsIgnoredParams;
+	TArray<AActor*> ActorsToIgnore;
+	UGameplayStatics::GetAllActorsOfClass(World, AShooterCharacter::StaticClass(), ActorsToIgnore);
+	CharactersIgnoredParams.AddIgnoredActors(ActorsToIgnore);
+	UGameplayStatics::GetAllActorsOfClass(World, AShooterBot::StaticClass(), ActorsToIgnore);
+	BotsIgnoredParams.AddIgnoredActors(ActorsToIgnore);
 
 	TArray<FVector> BehindCoverLocations;
 	// Get all behind cover points
@@ -52,6 +64,17 @@ void UAttackPositionTest::RunTest(FEnvQueryInstance& QueryInstance) const
 		float CurrentDistance;
 		float MinDistance = 100000;
 		const FVector Location = GetItemLocation(QueryInstance, *It);
+		if (CoverAnnotationIndex) {
+			// Only the annotations close enough to score matter
+			CoverAnnotationIndex->FindInRadius(Location, DiscardDistanceMax, NearAnnotations);
+			for (auto It2 = NearAnnotations.CreateConstIterator(); It2; ++It2) {
+				const FCoverAnnotationIndex::FCoverAnnotation& Annotation = CoverAnnotationIndex->GetAnnotation(*It2);
+				if (FVector::Dist(Annotation.CoverLocation, ContextLocations[0]) <= MaxRadius) {
+					CurrentDistance = FVector::Dist(Location, Annotation.Location);
+					MinDistance = (CurrentDistance < MinDistance) ? CurrentDistance : MinDistance;
+				}
+			}
+		}
 		for (auto It2 = LocationOfCoverAnnotations.CreateConstIterator(); It2; ++It2) {
 			const FVector CoverLocation = *It2;
 			CurrentDistance = FVector::Dist(Location, CoverLocation);
@@ -63,16 +86,11 @@ void UAttackPositionTest::RunTest(FEnvQueryInstance& QueryInstance) const
 		}
 		else if (World) {
 			FHitResult OutHit;
-			FCollisionQueryParams CollisionParams;
-			TArray<AActor*> ActorsToIgnore;
-
-			UGameplayStatics::GetAllActorsOfClass(World, AShooterCharacter::StaticClass(), ActorsToIgnore);
-			CollisionParams.AddIgnoredActors(ActorsToIgnore);
 
+			// The trace goes from the ground to the context, so the eyes height occupancy grid can't answer it
 			// Check distance to nearest cover and use it to score (the closer the better)
-			const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, Location, ContextLocations[0], ECollisionChannel::ECC_Visibility, CollisionParams);
+			const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, Location, ContextLocations[0], ECollisionChannel::ECC_Visibility, CharactersIgnoredParams);
 			if (BlockingHitFound) {
-				const float DistanceToCoverInContextDirection = FVector::Dist(OutHit.ImpactPoint, Location);
 				It.SetScore(TestPurpose, FilterType, MinDistance , MinThresholdValue, MaxThresholdValue);
 				//BehindCoverLocations.Add(Location);
 			}
@@ -88,14 +106,9 @@ void UAttackPositionTest::RunTest(FEnvQueryInstance& QueryInstance) const
 		const FVector Location = GetItemLocation(QueryInstance, *It3);
 
 		FHitResult OutHit;
-		FCollisionQueryParams CollisionParams;
-		TArray<AActor*> ActorsToIgnore;
-
-		UGameplayStatics::GetAllActorsOfClass(World, AShooterBot::StaticClass(), ActorsToIgnore);
-		CollisionParams.AddIgnoredActors(ActorsToIgnore);
 
 		// Check visibility to player
-		const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, Location, ContextLocations[0], ECollisionChannel::ECC_Visibility, CollisionParams);
+		const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, Location, ContextLocations[0], ECollisionChannel::ECC_Visibility, BotsIgnoredParams);
 		if (BlockingHitFound && OutHit.Actor->GetClass() == AShooterCharacter::StaticClass()) {
 			// There is visibility. Lets check distance to nearest cover!
 			float CurrentDistance;
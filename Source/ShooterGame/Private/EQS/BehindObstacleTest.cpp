@@ -49,8 +49,12 @@ void UBehindObstacleTest::RunTest(FEnvQueryInstance& QueryInstance) const
 		const FVector UpItemLocation = FVector(ItemLocation.X, ItemLocation.Y, HelperMethods::EYES_POS_Z);
 		
 		if (World) {
+			// A clear occupancy grid says nothing about the dynamic actors, the refined bake does
+			bool ItemIsVisible = false;
+			const bool KnownVisible = HelperMethods::GetBakedLineOfSight(World, UpItemLocation, EyesPosition, ItemIsVisible, true) && ItemIsVisible;
 
-			const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, UpItemLocation, EyesPosition, ECollisionChannel::ECC_Visibility, CollisionParams);
+			// The distance to the obstacle is needed for the score so only visible items skip the trace
+			const bool BlockingHitFound = KnownVisible ? false : World->LineTraceSingleByChannel(OutHit, UpItemLocation, EyesPosition, ECollisionChannel::ECC_Visibility, CollisionParams);
 
 			if (BlockingHitFound) {
 				FHitResult  OutHit1, OutHit2, OutHit3, OutHit4;
@@ -59,10 +63,10 @@ void UBehindObstacleTest::RunTest(FEnvQueryInstance& QueryInstance) const
 				const FVector UpItemLocation3 = FVector(UpItemLocation.X, UpItemLocation.Y + 75, UpItemLocation.Z);
 				const FVector UpItemLocation4 = FVector(UpItemLocation.X, UpItemLocation.Y - 75, UpItemLocation.Z);
 
-				const bool BlockingHitFound1 = World->LineTraceSingleByChannel(OutHit1, UpItemLocation1, EyesPosition, ECollisionChannel::ECC_Visibility, CollisionParams);
-				const bool BlockingHitFound2 = World->LineTraceSingleByChannel(OutHit2, UpItemLocation2, EyesPosition, ECollisionChannel::ECC_Visibility, CollisionParams);
-				const bool BlockingHitFound3 = World->LineTraceSingleByChannel(OutHit3, UpItemLocation3, EyesPosition, ECollisionChannel::ECC_Visibility, CollisionParams);
-				const bool BlockingHitFound4 = World->LineTraceSingleByChannel(OutHit4, UpItemLocation4, EyesPosition, ECollisionChannel::ECC_Visibility, CollisionParams);
+				const bool BlockingHitFound1 = IsBlocked(World, OutHit1, UpItemLocation1, EyesPosition, CollisionParams);
+				const bool BlockingHitFound2 = IsBlocked(World, OutHit2, UpItemLocation2, EyesPosition, CollisionParams);
+				const bool BlockingHitFound3 = IsBlocked(World, OutHit3, UpItemLocation3, EyesPosition, CollisionParams);
+				const bool BlockingHitFound4 = IsBlocked(World, OutHit4, UpItemLocation4, EyesPosition, CollisionParams);
 
 				if (BlockingHitFound1 && BlockingHitFound2 & BlockingHitFound3 && BlockingHitFound4) {
 					const float DistanceToCoverInEyesDirection = FVector::Dist(OutHit.ImpactPoint, UpItemLocation);
@@ -117,4 +121,16 @@ void UBehindObstacleTest::RunTest(FEnvQueryInstance& QueryInstance) const
 	}
 }
 
+bool UBehindObstacleTest::IsBlocked(UWorld * World, FHitResult &OutHit, const FVector From, const FVector To, const FCollisionQueryParams &CollisionParams) const {
+	// The grid only knows the static collision, so only a blocked answer is final
+	if (HelperMethods::GetGridLineOfSight(World, From, To) == ELineOfSight::Blocked) {
+		return true;
+	}
 
+	// Cells are 100uu wide and their centers can be inside the obstacles, only a visible answer is final
+	bool IsVisible;
+	if (HelperMethods::GetBakedLineOfSight(World, From, To, IsVisible, true) && IsVisible) {
+		return false;
+	}
+	return World->LineTraceSingleByChannel(OutHit, From, To, ECollisionChannel::ECC_Visibility, CollisionParams);
+}
@@ -68,6 +68,9 @@ void UCloserHighInfluencePositionsTest::RunTest(FEnvQueryInstance& QueryInstance
 
 		}
 		Score = 0.6 * ItemTile->Influence + 0.4 * (SumNeighborsInfluence / Neighbors.Num());
+		if (InfluenceMap->TileWasSearched(ItemTile->Index)) {
+			Score *= SearchedTileWeight;
+		}
 		It.SetScore(TestPurpose, FilterType, Score , MinThresholdValue, MaxThresholdValue);
 	}
 }
@@ -40,7 +40,7 @@ void UKeepFirstPositionTest::RunTest(FEnvQueryInstance& QueryInstance) const
 	}
 
 	//const FVector BotPosition = FVector(ContextLocations[0].X, ContextLocations[0].Y, HelperMethods::EYES_POS_Z);
-	const FVector BotPosition = FVector(-1490, 1460, 150);
+	const FVector BotPosition = FVector(-1490, 1460, HelperMethods::EYES_POS_Z);
 
 	TArray<FVector> FirstLocations;
 
@@ -50,14 +50,14 @@ void UKeepFirstPositionTest::RunTest(FEnvQueryInstance& QueryInstance) const
 
 	for (int Index1 = 0; Index1 < QueryInstance.Items.Num(); ++Index1) {
 		const FVector ItemLocation1 = GetItemLocation(QueryInstance, Index1);
-		const FVector UpLocation1 = FVector(ItemLocation1.X, ItemLocation1.Y, 150);
+		const FVector UpLocation1 = FVector(ItemLocation1.X, ItemLocation1.Y, HelperMethods::EYES_POS_Z);
 
 		FVector Item1ToBot = ItemLocation1 - BotPosition;
 		Item1ToBot.Normalize();
 
 		for (int Index2 = Index1 + 1; Index2 < QueryInstance.Items.Num() && FirstLocations.Contains(ItemLocation1); ++Index2) {
 			const FVector ItemLocation2 = GetItemLocation(QueryInstance, Index2);
-			const FVector UpLocation2 = FVector(ItemLocation2.X, ItemLocation2.Y, 150);
+			const FVector UpLocation2 = FVector(ItemLocation2.X, ItemLocation2.Y, HelperMethods::EYES_POS_Z);
 
 			FVector Item2ToBot = ItemLocation2 - BotPosition;
 			Item2ToBot.Normalize();
@@ -4,6 +4,7 @@
 #include "EnvironmentQuery/Contexts/EnvQueryContext_Querier.h"
 #include "EnvironmentQuery/Items/EnvQueryItemType_VectorBase.h"
 #include "Public/Bots/ShooterBot.h"
+#include "Public/Others/HelperMethods.h"
 #include "Public/EQS/NearBehindObstacleTest.h"
 
 
@@ -42,7 +43,7 @@ void UNearBehindObstacleTest::RunTest(FEnvQueryInstance& QueryInstance) const
 		if (TraceToPlayer) {
 			for (int Index = 0; Index < QueryInstance.Items.Num(); ++Index) {
 				const FVector ItemLocation = GetItemLocation(QueryInstance, Index);
-				const FVector UpLocation = FVector(ItemLocation.X, ItemLocation.Y, 150);
+				const FVector UpLocation = FVector(ItemLocation.X, ItemLocation.Y, HelperMethods::EYES_POS_Z);
 				if (World) {
 					FHitResult OutHit;
 					FCollisionQueryParams CollisionParams;
@@ -51,6 +52,13 @@ void UNearBehindObstacleTest::RunTest(FEnvQueryInstance& QueryInstance) const
 					UGameplayStatics::GetAllActorsOfClass(World, AShooterCharacter::StaticClass(), ActorsToIgnore);
 					CollisionParams.AddIgnoredActors(ActorsToIgnore);
 
+					// Visible items can't be behind an obstacle, skip their trace. The bake only knows
+					// static geometry, so refine before skipping: a dynamic blocker still makes a hiding spot
+					bool IsVisible;
+					if (HelperMethods::GetBakedLineOfSight(World, UpLocation, PlayerPositionFromAI, IsVisible, true) && IsVisible) {
+						continue;
+					}
+
 					// Check distance to nearest cover and use it to score (the closer the better)
 					const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, UpLocation, PlayerPositionFromAI, ECollisionChannel::ECC_Visibility, CollisionParams);
 					if (BlockingHitFound) {
@@ -77,7 +85,7 @@ void UNearBehindObstacleTest::RunTest(FEnvQueryInstance& QueryInstance) const
 
 		for (int Index = 0; Index < QueryInstance.Items.Num(); ++Index) {
 			const FVector ItemLocation = GetItemLocation(QueryInstance, Index);
-			const FVector UpLocation = FVector(ItemLocation.X, ItemLocation.Y, 150);
+			const FVector UpLocation = FVector(ItemLocation.X, ItemLocation.Y, HelperMethods::EYES_POS_Z);
 			int Hits = 0;
 			if (World) {
 				FHitResult OutHit;
@@ -90,6 +98,11 @@ void UNearBehindObstacleTest::RunTest(FEnvQueryInstance& QueryInstance) const
 				for (auto BotPosIterator = CharacterPositions.CreateConstIterator(); BotPosIterator; ++BotPosIterator) {
 					FVector BotPosition = *BotPosIterator;
 
+					bool IsVisible;
+					if (HelperMethods::GetBakedLineOfSight(World, UpLocation, BotPosition, IsVisible, true) && IsVisible) {
+						continue;
+					}
+
 					// Check distance to nearest cover and use it to score (the closer the better)
 					const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, UpLocation, BotPosition, ECollisionChannel::ECC_Visibility, CollisionParams);
 					if (BlockingHitFound) {
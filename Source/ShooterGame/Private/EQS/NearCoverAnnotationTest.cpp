@@ -38,19 +38,35 @@ void UNearCoverAnnotationTest::RunTest(FEnvQueryInstance& QueryInstance) const
 
 	ANavigationData* NavData = NavSys->GetMainNavData(FNavigationSystem::Create);
 	AMyRecastNavMesh* MyNavMesh = Cast<AMyRecastNavMesh>(NavData);
-	FRecastQueryFilter_Example* MyFRecastQueryFilter = MyNavMesh->GetCustomFilter();
-
-	const FVector PlayerLocation = HelperMethods::GetPlayerPositionFromAI(World);
-	const FVector PlayerForwardVector = HelperMethods::GetPlayerForwardVectorFromAI(World);
-	const TArray<Triangle> VisibleTriangles = HelperMethods::CalculateVisibility(World, PlayerLocation, PlayerForwardVector);
-	
-
+	// Covers are only known through the index of the navmesh
+	const FCoverAnnotationIndex* CoverAnnotationIndex = MyNavMesh && MyNavMesh->GetCoverAnnotations().Num() > 0 ? &MyNavMesh->GetCoverAnnotations() : NULL;
 
+	TArray<FVector> ContextLocations;
+	if (Context && !QueryInstance.PrepareContext(Context, ContextLocations))
+	{
+		return;
+	}
 
+	TArray<int32> NearAnnotations;
 	// Get all behind cover points
 	for (FEnvQueryInstance::ItemIterator It(this, QueryInstance); It; ++It)
 	{
-		It.SetScore(TestPurpose, FilterType, true, bWantsHit);
+		const FVector Location = GetItemLocation(QueryInstance, *It);
+		bool bNearCover = !CoverAnnotationIndex;
+		if (CoverAnnotationIndex && ContextLocations.Num() == 0) {
+			bNearCover = CoverAnnotationIndex->FindNearest(Location, MaxDistance) != INDEX_NONE;
+		}
+		else if (CoverAnnotationIndex) {
+			// The annotation is on the side of its cover away from the context
+			CoverAnnotationIndex->FindNearest(Location, MaxDistance, FCoverAnnotationIndex::MAX_NEAREST, NearAnnotations);
+			for (auto It2 = NearAnnotations.CreateConstIterator(); It2 && !bNearCover; ++It2) {
+				const FCoverAnnotationIndex::FCoverAnnotation& Annotation = CoverAnnotationIndex->GetAnnotation(*It2);
+				const FVector2D ToCover = FVector2D(Annotation.CoverLocation - Annotation.Location);
+				const FVector2D ToContext = FVector2D(ContextLocations[0] - Annotation.Location);
+				bNearCover = FVector2D::DotProduct(ToCover, ToContext) > 0 && ToCover.SizeSquared() < ToContext.SizeSquared();
+			}
+		}
+		It.SetScore(TestPurpose, FilterType, bNearCover, bWantsHit);
 	}
 }
 
@@ -5,6 +5,7 @@
 #include "AI/Navigation/NavigationSystem.h"
 #include "AI/Navigation/NavAgentInterface.h"
 #include "Public/Navigation/MyNavigationQueryFilter.h"
+#include "Public/Others/CoverTravelData.h"
 #include "EnvironmentQuery/Contexts/EnvQueryContext_Querier.h"
 #include "EnvironmentQuery/Items/EnvQueryItemType_VectorBase.h"
 //#include "AIModulePrivate.h"
@@ -20,6 +21,7 @@ UPathfiningTest::UPathfiningTest(const FObjectInitializer& ObjectInitializer) :
 	TestMode = EEnvTestPathfinding::PathExist;
 	PathFromContext.DefaultValue = true;
 	SkipUnreachable.DefaultValue = true;
+	bUseCoverTravelTable = false;
 	FloatValueMin.DefaultValue = 1000.0f;
 	FloatValueMax.DefaultValue = 1000.0f;
 
@@ -73,6 +75,60 @@ void UPathfiningTest::RunTest(FEnvQueryInstance& QueryInstance) const
 		return;
 	}
 
+	// With our filter one flow field per context answers every item (costs are the same in both directions)
+	if (!FilterClass || FilterClass->IsChildOf(UMyNavigationQueryFilter::StaticClass()))
+	{
+		// Travel between baked waypoints is a table read. It knows no threats, so it does not answer PathCost
+		const UCoverTravelData* CoverTravel = bUseCoverTravelTable && TestMode != EEnvTestPathfinding::PathCost ? NavData->GetCoverTravel() : NULL;
+
+		// Flow fields are only built for the contexts the table does not answer
+		TArray<TSharedPtr<const FNavFlowField>> FlowFields;
+		TBitArray<> FlowFieldsBuilt(false, ContextLocations.Num());
+		FlowFields.SetNum(ContextLocations.Num());
+
+		for (FEnvQueryInstance::ItemIterator It(this, QueryInstance); It; ++It)
+		{
+			const FVector ItemLocation = GetItemLocation(QueryInstance, It.GetIndex());
+			const dtPolyRef ItemPoly = NavData->GetFlowFieldPoly(ItemLocation);
+			for (int32 ContextIndex = 0; ContextIndex < ContextLocations.Num(); ContextIndex++)
+			{
+				float TravelTime = BIG_NUMBER;
+				const bool bTableAnswered = CoverTravel && CoverTravel->GetTravelTime(NavData, ContextLocations[ContextIndex], ItemLocation, TravelTime);
+				if (!bTableAnswered && !FlowFieldsBuilt[ContextIndex])
+				{
+					FlowFields[ContextIndex] = NavData->GetFlowField(ContextLocations[ContextIndex]);
+					FlowFieldsBuilt[ContextIndex] = true;
+				}
+
+				const TSharedPtr<const FNavFlowField>& FlowField = FlowFields[ContextIndex];
+				const bool bReachable = bTableAnswered ? TravelTime < BIG_NUMBER : ItemPoly && FlowField.IsValid() && FlowField->IsReachable(ItemPoly);
+				if (GetWorkOnFloatValues())
+				{
+					float PathValue = BIG_NUMBER;
+					if (bReachable && bTableAnswered)
+					{
+						PathValue = TravelTime * CoverTravel->WalkSpeed;
+					}
+					else if (bReachable)
+					{
+						PathValue = (TestMode == EEnvTestPathfinding::PathLength) ? FlowField->GetLength(ItemPoly, ItemLocation) : FlowField->GetCost(ItemPoly, ItemLocation);
+					}
+					It.SetScore(TestPurpose, FilterType, PathValue, MinThresholdValue, MaxThresholdValue);
+
+					if (bDiscardFailed && PathValue >= BIG_NUMBER)
+					{
+						It.ForceItemState(EEnvItemStatus::Failed);
+					}
+				}
+				else
+				{
+					It.SetScore(TestPurpose, FilterType, bReachable, bWantsPath);
+				}
+			}
+		}
+		return;
+	}
+
 	EPathFindingMode::Type PFMode(EPathFindingMode::Regular);
 
 	if (GetWorkOnFloatValues())
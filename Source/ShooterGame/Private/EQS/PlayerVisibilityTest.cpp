@@ -6,6 +6,7 @@
 #include "Public/EQS/CoverBaseClass.h"
 #include "Public/Bots/ShooterBot.h"
 #include "Public/Others/HelperMethods.h"
+#include "Public/Others/PlayerVisibilitySnapshot.h"
 #include "Public/EQS/PlayerVisibilityTest.h"
 
 UPlayerVisibilityTest::UPlayerVisibilityTest(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
@@ -38,19 +39,27 @@ void UPlayerVisibilityTest::RunTest(FEnvQueryInstance& QueryInstance) const
 		// Custom method
 		// Get all covers annotations within radius
 
-		const TArray<Triangle> PlayerVisibility = HelperMethods::CalculateVisibility(World, PlayerLocation, PlayerForwardVector);
+		// Shared snapshot of this frame when the bots have one, otherwise compute it here
+		FPlayerVisibilitySnapshotPtr Snapshot = PlayerVisibilitySnapshots::Get(World);
+		if (!Snapshot.IsValid() || Snapshot->Location != PlayerLocation) {
+			Snapshot = MakeShareable(new FPlayerVisibilitySnapshot(PlayerLocation, PlayerForwardVector, HelperMethods::CalculateVisibility(World, PlayerLocation, PlayerForwardVector)));
+		}
+		const FVisibilityFan& PlayerVisibility = *Snapshot->Fan;
+
+		// Test all the items in one batch (indexed like QueryInstance.Items), then score them
+		TArray<FVector2D> Locations;
+		Locations.Reserve(QueryInstance.Items.Num());
+		for (int32 Index = 0; Index < QueryInstance.Items.Num(); ++Index) {
+			const FVector Location = GetItemLocation(QueryInstance, Index);
+			Locations.Add(FVector2D(Location.X, Location.Y));
+		}
+
+		TArray<bool> LocationsVisible;
+		PlayerVisibility.ArePointsInside(Locations, LocationsVisible);
+
 		for (FEnvQueryInstance::ItemIterator It(this, QueryInstance); It; ++It)
 		{
-			bool IsVisible = false;
-			const FVector Location = GetItemLocation(QueryInstance, *It);
-			for (auto It2 = PlayerVisibility.CreateConstIterator(); It2; ++It2) {
-				const Triangle Triangle = *It2;
-				if (Triangle.PointInsideTriangle(FVector2D(Location.X, Location.Y))) {
-					IsVisible = true;
-					break;
-				}
-			}
-			It.SetScore(TestPurpose, FilterType, IsVisible, bWantsHit);
+			It.SetScore(TestPurpose, FilterType, LocationsVisible[*It], bWantsHit);
 		}
 	}
 	else {
@@ -66,10 +75,14 @@ void UPlayerVisibilityTest::RunTest(FEnvQueryInstance& QueryInstance) const
 		for (FEnvQueryInstance::ItemIterator It2(this, QueryInstance); It2; ++It2)
 		{
 			const FVector Location = GetItemLocation(QueryInstance, *It2);
-			const FVector UpLocation = FVector(Location.X, Location.Y, 150);
-			const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, EyesLocation, UpLocation, ECollisionChannel::ECC_Visibility, CollisionParams);
+			const FVector UpLocation = FVector(Location.X, Location.Y, HelperMethods::EYES_POS_Z);
+			// Cells are 100uu wide and their centers can be inside the obstacles, only a visible answer is final
+			bool IsVisible;
+			if (!HelperMethods::GetBakedLineOfSight(World, EyesLocation, UpLocation, IsVisible, true) || !IsVisible) {
+				IsVisible = !World->LineTraceSingleByChannel(OutHit, EyesLocation, UpLocation, ECollisionChannel::ECC_Visibility, CollisionParams);
+			}
 
-			It2.SetScore(TestPurpose, FilterType, !BlockingHitFound, bWantsHit);
+			It2.SetScore(TestPurpose, FilterType, IsVisible, bWantsHit);
 		}
 	}
 
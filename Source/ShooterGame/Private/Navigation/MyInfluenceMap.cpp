@@ -7,7 +7,7 @@ using namespace std;
 
 void AMyInfluenceMap::Initialize() {
 	// Setup basic influence map
-	BotsVisibilities = new TMap<FString, TArray<Triangle>>();
+	TBitArray<> OpaqueTiles(false, Width * Height);
 	for (int Index = 0; Index < Width*Height; ++Index) {
 		InfluenceTile * Tile = new InfluenceTile();
 		Tile->Influence = 0;
@@ -26,11 +26,16 @@ void AMyInfluenceMap::Initialize() {
 
 		Influences.Add(Tile);
 		LocalInfluences.Add(LocalTile);
+		OpaqueTiles[Index] = !Tile->IsWalkable;
 
 		UpdatedTexture->SetColorOfPixel(Tile->X, Tile->Y, BaseTexture->GetColorOfPixel(Tile->X, Tile->Y));
 
 	}
 
+	TilesFOV.Initialize(OpaqueTiles, Width, Height);
+	TilesVisibleCount.Init(0, Width * Height);
+	SearchedTiles.Init(false, Width * Height);
+
 	UpdatedTexture->Update();
 }
 
@@ -218,28 +223,51 @@ void AMyInfluenceMap::Destroyed() {
 
 
 void AMyInfluenceMap::a() {
-	for (auto It = Influences.CreateConstIterator(); It; ++It) {
-		InfluenceTile * Tile = *It;
-		if (TileIsVisible(Tile)) {
-			Tile->Influence = -100000;
+	for (auto ItBots = BotsVisibleTiles.CreateConstIterator(); ItBots; ++ItBots) {
+		for (auto It = ItBots.Value().CreateConstIterator(); It; ++It) {
+			Influences[*It]->Influence = -100000;
 		}
 	}
 }
 
-void AMyInfluenceMap::SetBotVisibility(FString BotName, TArray<Triangle> Visibility) {
-	
-	BotsVisibilities->Add(BotName, Visibility);
+void AMyInfluenceMap::SetBotVisibility(const FString& BotName, const FVector Location, const FVector ForwardVector, const float ViewAngle, const float ViewDistance) {
+	const FVector TileLocation = BaseTexture->WorldSpaceToTexture(Location);
+	// Tiles are not square in world space, move the forward vector and the range to tiles
+	const float TilesPerUnitX = (float)Width / (MyTexture2D::MaxX - MyTexture2D::MinX);
+	const float TilesPerUnitY = (float)Height / (MyTexture2D::MaxY - MyTexture2D::MinY);
+	const FVector2D TileForward = FVector2D(ForwardVector.X * TilesPerUnitX, ForwardVector.Y * TilesPerUnitY);
+	const float TileRange = ViewDistance * FMath::Max(TilesPerUnitX, TilesPerUnitY);
+
+	RemoveBotVisibility(BotName);
+	TArray<int32>& VisibleTiles = BotsVisibleTiles.Add(BotName);
+	TilesFOV.GetVisibleCells(TileLocation.X, TileLocation.Y, TileForward, ViewAngle, TileRange, VisibleTiles);
+
+	for (auto It = VisibleTiles.CreateConstIterator(); It; ++It) {
+		++TilesVisibleCount[*It];
+		if (Influences[*It]->IsWalkable) {
+			SearchedTiles[*It] = true;
+		}
+	}
 }
 
-bool AMyInfluenceMap::TileIsVisible(InfluenceTile * Tile) {
-	for (auto ItBots = BotsVisibilities->CreateConstIterator(); ItBots; ++ItBots) {
-		TArray<Triangle> BotVisibility = ItBots.Value();
-		for (auto ItTriangles = BotVisibility.CreateConstIterator(); ItTriangles; ++ItTriangles) {
-			Triangle triangle = *ItTriangles;
-			if (triangle.PointInsideTriangle(BaseTexture->TextureToWorldSpace(Tile->X, Tile->Y))) {
-				return true;
-			}
+void AMyInfluenceMap::RemoveBotVisibility(const FString& BotName) {
+	const TArray<int32>* OldVisibleTiles = BotsVisibleTiles.Find(BotName);
+	if (OldVisibleTiles) {
+		for (auto It = OldVisibleTiles->CreateConstIterator(); It; ++It) {
+			--TilesVisibleCount[*It];
 		}
+		BotsVisibleTiles.Remove(BotName);
 	}
-	return false;
-}
\ No newline at end of file
+}
+
+bool AMyInfluenceMap::TileWasSearched(const int Index) const {
+	return Index >= 0 && Index < SearchedTiles.Num() && SearchedTiles[Index];
+}
+
+void AMyInfluenceMap::ClearSearchedTiles() {
+	SearchedTiles.Init(false, Width * Height);
+}
+
+bool AMyInfluenceMap::TileIsVisible(InfluenceTile * Tile) {
+	return TilesVisibleCount[Tile->Index] > 0;
+}
@@ -18,24 +18,8 @@ void UMyNavigationQueryFilter::InitializeFilter(const ANavigationData& NavData,
 	if (MyNavData) {
 		const FRecastQueryFilter_Example* MyFRecastQueryFilter = MyNavData->GetCustomFilter();
 		if (MyFRecastQueryFilter) {
-			Filter.SetFilterType<FRecastQueryFilter_Example>();
-			
-			UWorld * World = GetWorld();
-
-			if (World) {
-				const FVector PlayerLocation = HelperMethods::GetPlayerPositionFromAI(World);
-				const FVector PlayerForwardVector = HelperMethods::GetPlayerPositionFromAI(World);
-
-				const TArray<Triangle> VisibleTriangles = HelperMethods::CalculateVisibility(World, PlayerLocation, PlayerForwardVector);
-
-				// Update Navigation Mesh
-				dtQueryFilter_Example::SetPlayerVisibility(VisibleTriangles);
-			}
-			
-
-
-
-			//Filter.SetFilterImplementation(MyFRecastQueryFilter); 
+			// Copy of the navmesh filter: same threat publisher, the threat field is captured per query
+			Filter.SetFilterImplementation(MyFRecastQueryFilter);
 		}
 	}
 	else {
@@ -8,15 +8,42 @@
 #include "Runtime/Navmesh/Public/Detour/DetourCommon.h"
 #include "Public/Navigation/MyRecastNavMesh.h"
 #include "Public/Navigation/CubeComponent.h"
+#include "Public/Navigation/NavArea_Exposed.h"
+#include "Public/Navigation/NavArea_PartiallyExposed.h"
+#include "Public/Others/CellVisibilityData.h"
+#include "Public/Others/CoverTravelData.h"
+#include "Public/Others/OccluderSegmentData.h"
+#include "Public/Others/HelperMethods.h"
+#include "Bots/ShooterAIController.h"
 
 //----------------------------------------------------------------------//
 // dtQueryFilter_Example();
 //----------------------------------------------------------------------//
-TArray<Triangle> dtQueryFilter_Example::PlayerVisibleAreas;
+// Cost multiplier of the distance walked inside the player visibility
+static const float VISIBLE_COST_MULTIPLIER = 1.1f;
+// Extent used to find the poly of the flow fields sources and items
+static const FVector FLOW_FIELD_QUERY_EXTENT = FVector(100, 100, 300);
+// Polys seen at least this much are tagged as exposed, the rest with some visibility as partially exposed
+static const float EXPOSED_POLY_FRACTION = 0.75f;
+// Frames a pending retag may hold the request queue, then the queue dispatches one frame before holding again
+static const int32 MAX_THREAT_AREAS_HOLD_FRAMES = 4;
+
+void dtQueryFilter_Example::SetThreatPublisher(const FThreatFieldPublisherPtr& Publisher) {
+	ThreatPublisher = Publisher;
+	CaptureThreatField();
+}
 
-bool dtQueryFilter_Example::SetPlayerVisibility(const TArray<Triangle> VisibleAreas) {
-	PlayerVisibleAreas = VisibleAreas;
-	return true;;
+void dtQueryFilter_Example::CaptureThreatField() {
+	if (ThreatPublisher.IsValid()) {
+		ThreatField = ThreatPublisher->GetLatest();
+	}
+	else {
+		ThreatField.Reset();
+	}
+}
+
+const FThreatFieldPtr& dtQueryFilter_Example::GetThreatField() const {
+	return ThreatField;
 }
 
 /// Returns cost to move from the beginning to the end of a line segment
@@ -35,71 +62,32 @@ bool dtQueryFilter_Example::SetPlayerVisibility(const TArray<Triangle> VisibleAr
 
 float dtQueryFilter_Example::getVirtualCost(const float * pa, const float * pb, const dtPolyRef prevRef, const dtMeshTile * prevTile, const dtPoly * prevPoly, const dtPolyRef curRef, const dtMeshTile * curTile, const dtPoly * curPoly, const dtPolyRef nextRef, const dtMeshTile * nextTile, const dtPoly * nextPoly) const
 {
-	const float cost = GetCustomCost(FVector2D(-pa[0], -pa[2]), FVector2D(-pb[0], -pb[2]));
-	//UE_LOG(LogTemp, Warning, TEXT("Cost from P(%f,%f) to P(%f,%f) - Cost: %f"), -pa[0], -pa[2], -pb[0], -pb[2], cost);
-	return cost; 
-}
-
-float dtQueryFilter_Example::GetCustomCost(const FVector2D StartPosition, const FVector2D EndPosition) const {
-	float DefaultCost = 1; 	// Default pathfinding cost
-	float Cost = 0;
-	float ContinuousCostInsideDangerArea = 0;
-
-	FVector2D PreviousPosition = StartPosition;
-	FVector2D CurrentPosition = StartPosition;
-	while (FVector2D::Distance(CurrentPosition, EndPosition) > 1) {		
-		CurrentPosition = PreviousPosition + GetMinimumVector(StartPosition, EndPosition);
-		const float Distance = FVector2D::DistSquared(PreviousPosition, CurrentPosition);
-		if (PositionIsVisibleByPlayer(PreviousPosition)) {
-			ContinuousCostInsideDangerArea += Distance * DefaultCost;
-		}
-		else {
-			if (ContinuousCostInsideDangerArea > 0) {
-				Cost += ContinuousCostInsideDangerArea * 1.1;
-				//Cost += FMath::Pow(ContinuousCostInsideDangerArea, 2);
-				ContinuousCostInsideDangerArea = 0;
-			}
-			Cost += Distance * DefaultCost;
-		}
-		PreviousPosition = CurrentPosition;
-	}
-
-	if (ContinuousCostInsideDangerArea > 0) {
-		Cost += ContinuousCostInsideDangerArea * 1.1;
-		//Cost += FMath::Pow(ContinuousCostInsideDangerArea, 2);
+	const FVector2D Start = FVector2D(-pa[0], -pa[2]);
+	const FVector2D End = FVector2D(-pb[0], -pb[2]);
+	const float Length = FVector2D::Distance(Start, End);
+
+	// Exact bounds reject only, the sampled poly fraction can miss a fan crossing the segment
+	FBox2D SegmentBounds(ForceInit);
+	SegmentBounds += Start;
+	SegmentBounds += End;
+	if (!ThreatField.IsValid() || !ThreatField->MayBeVisible(SegmentBounds)) {
+		return Length;
 	}
 
-	return Cost;
-}
-
-FVector2D dtQueryFilter_Example::GetMinimumVector(const FVector2D StartPosition, const FVector2D EndPosition) const {
-	const FVector2D OriginalVector = EndPosition - StartPosition;
-	float size = OriginalVector.Size();
-	return OriginalVector / 10;
+	// Only the part of the segment seen by the player is more expensive
+	const float ExposedLength = FMath::Min(ThreatField->GetExposedLength(Start, End), Length);
+	return Length + (VISIBLE_COST_MULTIPLIER - 1) * ExposedLength;
 }
 
 bool dtQueryFilter_Example::PositionIsVisibleByPlayer(const FVector2D Position) const {
-	for (auto It = PlayerVisibleAreas.CreateConstIterator(); It; ++It) {
-		Triangle Triangle = *It;
-		if (Triangle.PointInsideTriangle(Position)) {
-			return true;
-		}
-	}
-
-	return false;
+	return ThreatField.IsValid() && ThreatField->IsPointVisible(Position);
 }
 
 float dtQueryFilter_Example::GetCostOfPosition(const FVector2D Position) const {
 	float Cost = 1;
-	for (auto It = PlayerVisibleAreas.CreateConstIterator(); It; ++It) {
-		Triangle Triangle = *It;
-		if (Triangle.PointInsideTriangle(Position)) {
-			const float DistanceToPlayer = FVector2D::Distance(Position, FVector2D(Triangle.V2.X, Triangle.V2.Y));
-			
-			Cost = 20;
-			//Cost = 100;
-			break;
-		}
+	if (PositionIsVisibleByPlayer(Position)) {
+		Cost = 20;
+		//Cost = 100;
 	}
 
 	return Cost;
@@ -138,7 +126,10 @@ FRecastQueryFilter_Example::FRecastQueryFilter_Example(bool bIsVirtual)
 
 INavigationQueryFilterInterface* FRecastQueryFilter_Example::CreateCopy() const
 {
-	return new FRecastQueryFilter_Example(*this);
+	// Copies are made for new queries, they see the latest threats
+	FRecastQueryFilter_Example* Copy = new FRecastQueryFilter_Example(*this);
+	Copy->CaptureThreatField();
+	return Copy;
 }
 
 void FRecastQueryFilter_Example::SetIsVirtual(bool bIsVirtual)
@@ -243,17 +234,75 @@ AMyRecastNavMesh::AMyRecastNavMesh(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
 	PrimaryActorTick.bCanEverTick = true;
+	ThreatPublisher = MakeShareable(new FThreatFieldPublisher());
+	PathCache = MakeShareable(new FNavPathCache());
+	PathRequestQueue = MakeShareable(new FNavPathRequestQueue());
+	ThreatAreasVersion = 0;
+	ThreatAreasHeldFrames = 0;
+	AgentPlannersVersion = 0;
+	ClusterGraph = MakeShareable(new FNavClusterGraph());
+	bClusterGraphDirty = true;
+	FindPathImplementation = AMyRecastNavMesh::FindPath;
 }
 
 void AMyRecastNavMesh::BeginPlay() {
 	Super::BeginPlay();
 	Timer = 0;
+	// Tiles rebuilt on load would replace the mapped ones
+	if (MAPPED_TILES && GetWorld()->IsGameWorld() && !bForceRebuildOnLoad) {
+		LoadMappedTiles();
+	}
 	SetupCustomNavFilter();
+	bClusterGraphDirty = true;
+	PathRequestQueue->OnQueuedPathFound.BindUObject(this, &AMyRecastNavMesh::OnQueuedPathFound);
+
+	const FBox Bounds = GetBounds();
+	CoverageBounds = FBox2D(FVector2D(Bounds.Min.X, Bounds.Min.Y), FVector2D(Bounds.Max.X, Bounds.Max.Y));
+
+	CellVisibility = UCellVisibilityData::LoadForWorld(GetWorld());
+	if (!CellVisibility) {
+		UE_LOG(LogNavigation, Log, TEXT("AMyRecastNavMesh: no baked cell visibility at %s, AI line of sight will use traces"), *UCellVisibilityData::GetAssetPath(GetWorld()));
+	}
+
+	CoverAnnotations.Build(GetWorld());
+
+	CoverTravel = UCoverTravelData::LoadForWorld(GetWorld());
+	if (!CoverTravel) {
+		UE_LOG(LogNavigation, Log, TEXT("AMyRecastNavMesh: no baked cover travel at %s, EQS travel will path find"), *UCoverTravelData::GetAssetPath(GetWorld()));
+	}
+
+	Occluders = UOccluderSegmentData::LoadForWorld(GetWorld());
+	if (!Occluders) {
+		UE_LOG(LogNavigation, Log, TEXT("AMyRecastNavMesh: no baked occluders at %s, visibility will use cover actors bounds"), *UOccluderSegmentData::GetAssetPath(GetWorld()));
+	}
+	else if (CoverageBounds.bIsValid) {
+		OcclusionHeightGrid = MakeShareable(new FOcclusionHeightGrid(CoverageBounds));
+		OcclusionHeightGrid->AddOccluders(Occluders);
+
+		OccupancyGrid = MakeShareable(new FOccupancyGrid(CoverageBounds, HelperMethods::EYES_POS_Z));
+		OccupancyGrid->AddOccluders(Occluders);
+	}
+}
+
+void AMyRecastNavMesh::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+	UE_LOG(LogShooter, Log, TEXT("Path cache: %u hits, %u misses (%.1f%% hit rate), %d entries"), PathCache->GetHits(), PathCache->GetMisses(), PathCache->GetHitRate() * 100, PathCache->Num());
+	Super::EndPlay(EndPlayReason);
 }
 
 void AMyRecastNavMesh::Tick(float deltaTime)
 {
 	Super::Tick(deltaTime); 
+	// A pending retag holds the queue (a few frames at most) so the in flight queries drain and the areas can be written
+	const bool ThreatAreasUpdated = !THREAT_AREAS || UpdateThreatAreas();
+	if (INCREMENTAL_REPLANNING) {
+		InvalidateAgentPaths();
+	}
+	if (CLUSTER_GRAPH) {
+		UpdateClusterGraph();
+	}
+	if (ThreatAreasUpdated) {
+		PathRequestQueue->Process(GetWorld()->GetNavigationSystem());
+	}
 	/*
 	if (Timer <= dtQueryFilter_Example::UPDATE_FREQ) {
 		Timer += deltaTime;
@@ -264,15 +313,519 @@ void AMyRecastNavMesh::Tick(float deltaTime)
 	}*/
 }
 
+void AMyRecastNavMesh::OnNavMeshTilesUpdated(const TArray<uint32>& ChangedTiles) {
+	Super::OnNavMeshTilesUpdated(ChangedTiles);
+	bClusterGraphDirty = true;
+	for (int32 Index = 0; Index < ChangedTiles.Num(); ++Index) {
+		ClusterGraphTiles.AddUnique(ChangedTiles[Index]);
+	}
+	// Their nodes are polys of the old tiles
+	FlowFields.Empty();
+	PathCache->Empty();
+	for (auto It = AgentPlanners.CreateIterator(); It; ++It) {
+		It.Value().Planner.Reset();
+	}
+}
+
+void AMyRecastNavMesh::UpdateClusterGraph() {
+	const dtNavMesh* DetourMesh = GetRecastMesh();
+	if (!DetourMesh || !GetCustomFilter()) {
+		return;
+	}
+
+	const uint32 Version = GetThreatVersion();
+	const FBox2D ThreatBounds = GetThreatBounds();
+	// Costs only changed where the player saw before or sees now
+	FBox2D ChangedArea(0);
+	if (ClusterGraph->GetFilterVersion() != Version) {
+		ChangedArea = ClusterGraphThreatBounds;
+		ChangedArea += ThreatBounds;
+	}
+	if (bClusterGraphDirty) {
+		// The whole graph the first time
+		ClusterGraph->RebuildTiles(DetourMesh, ClusterGraphTiles, CreateBaseFilter(), CreateThreatFilter(), Version, ChangedArea);
+		UE_LOG(LogNavigation, Log, TEXT("AMyRecastNavMesh: cluster graph with %d clusters and %d entrances"), ClusterGraph->GetNumClusters(), ClusterGraph->GetNumEntrances());
+		ClusterGraphTiles.Reset();
+		bClusterGraphDirty = false;
+	}
+	else if (ClusterGraph->GetFilterVersion() != Version) {
+		// Only re-costs the stored corridors, cheap enough for every threat version
+		ClusterGraph->UpdateFilter(CreateBaseFilter(), CreateThreatFilter(), Version, ChangedArea);
+	}
+	ClusterGraphThreatBounds = ThreatBounds;
+}
+
 void AMyRecastNavMesh::SetupCustomNavFilter() {
+	DefaultNavFilter.SetThreatPublisher(ThreatPublisher);
+	if (THREAT_AREAS) {
+		// Stock Detour costs, the danger is in the cost of the tagged areas
+		DefaultNavFilter.SetIsVirtual(false);
+		const int32 ExposedArea = GetAreaID(UNavArea_Exposed::StaticClass());
+		if (ExposedArea != INDEX_NONE) {
+			DefaultNavFilter.SetAreaCost(ExposedArea, GetDefault<UNavArea_Exposed>()->DefaultCost);
+		}
+		const int32 PartiallyExposedArea = GetAreaID(UNavArea_PartiallyExposed::StaticClass());
+		if (PartiallyExposedArea != INDEX_NONE) {
+			DefaultNavFilter.SetAreaCost(PartiallyExposedArea, GetDefault<UNavArea_PartiallyExposed>()->DefaultCost);
+		}
+	}
 	if (DefaultQueryFilter.IsValid())
 	{
 		DefaultQueryFilter->SetFilterImplementation(dynamic_cast<const INavigationQueryFilterInterface*>(&DefaultNavFilter));
 	}
 }
 
+void AMyRecastNavMesh::LoadMappedTiles() {
+	dtNavMesh* DetourMesh = GetRecastMesh();
+	const FString FileName = FNavTileBlob::GetFileName(GetWorld());
+	TSharedPtr<FNavTileBlob> Blob = FNavTileBlob::Map(FileName);
+	if (!DetourMesh || !Blob.IsValid()) {
+		return;
+	}
+	if (!Blob->MatchesParams(*DetourMesh->getParams())) {
+		UE_LOG(LogNavigation, Warning, TEXT("AMyRecastNavMesh: %s was baked with another navmesh layout, bake it again"), *FileName);
+		return;
+	}
+
+	// The serialized tiles own their data, detour frees it
+	const dtNavMesh* ConstDetourMesh = DetourMesh;
+	for (int32 TileIndex = 0; TileIndex < ConstDetourMesh->getMaxTiles(); ++TileIndex) {
+		const dtMeshTile* Tile = ConstDetourMesh->getTile(TileIndex);
+		if (Tile && Tile->header) {
+			DetourMesh->removeTile(ConstDetourMesh->getTileRef(Tile), NULL, NULL);
+		}
+	}
+
+	// Added without DT_TILE_FREE_DATA: detour points the tiles into the mapped pages
+	int32 NumFailed = 0;
+	for (int32 Index = 0; Index < Blob->GetNumTiles(); ++Index) {
+		if (dtStatusFailed(DetourMesh->addTile(Blob->GetTileData(Index), Blob->GetTileDataSize(Index), 0, 0, NULL))) {
+			++NumFailed;
+		}
+	}
+	TileBlob = Blob;
+	UE_LOG(LogNavigation, Log, TEXT("AMyRecastNavMesh: %d tiles from %s (%s), %d failed"), Blob->GetNumTiles(), *FileName, Blob->IsMapped() ? TEXT("mapped") : TEXT("read"), NumFailed);
+}
+
 FRecastQueryFilter_Example* AMyRecastNavMesh::GetCustomFilter() const  {
 	FRecastQueryFilter_Example* MyFRecastQueryFilter = reinterpret_cast<FRecastQueryFilter_Example*>(DefaultQueryFilter.Get()->GetImplementation());
 	return MyFRecastQueryFilter;
 }
 
+// Path of the query built from a known corridor, only the string pulling is done
+static FPathFindingResult BuildCorridorPath(const AMyRecastNavMesh* NavMesh, const FPathFindingQuery& Query, const FNavCachedCorridor& Corridor) {
+	FNavMeshPath* NavMeshPath = Query.PathInstanceToFill.IsValid() ? Query.PathInstanceToFill->CastPath<FNavMeshPath>() : NULL;
+	FNavPathSharedPtr Path;
+	if (NavMeshPath) {
+		Path = Query.PathInstanceToFill;
+		NavMeshPath->ResetForRepath();
+	}
+	else {
+		NavMeshPath = new FNavMeshPath();
+		Path = MakeShareable(NavMeshPath);
+		NavMeshPath->SetNavigationDataUsed(NavMesh);
+		NavMeshPath->SetQuerier(Query.Owner.Get());
+	}
+	NavMeshPath->PathCorridor = Corridor.Corridor;
+	NavMeshPath->PathCorridorCost = Corridor.CorridorCost;
+	NavMeshPath->PerformStringPulling(Query.StartLocation, Query.EndLocation);
+	NavMeshPath->MarkReady();
+
+	FPathFindingResult Result(ENavigationQueryResult::Success);
+	Result.Path = Path;
+	return Result;
+}
+
+FPathFindingResult AMyRecastNavMesh::FindPath(const FNavAgentProperties& AgentProperties, const FPathFindingQuery& Query) {
+	const AMyRecastNavMesh* Self = Cast<const AMyRecastNavMesh>(Query.NavData.Get());
+	if (!Self || !Query.QueryFilter.IsValid()) {
+		return ARecastNavMesh::FindPath(AgentProperties, Query);
+	}
+
+	// Bots know their poly, only the box query is skipped. The tracker and the planners are game thread only,
+	// the queries of the request queue come with the poly the bot was on when it was queued
+	dtPolyRef StartPoly = 0;
+	if (IsInGameThread()) {
+		const AShooterAIController* Bot = Cast<const AShooterAIController>(Query.Owner.Get());
+		FNavLocation TrackedStart;
+		StartPoly = Bot && Bot->GetNavPolyTracker().FindNearby(Self, Query.StartLocation, TrackedStart) ? TrackedStart.NodeRef : Self->GetFlowFieldPoly(Query.StartLocation);
+
+		FPathFindingResult Result;
+		if (Self->FindIncrementalPath(Query, StartPoly, Result)) {
+			return Result;
+		}
+	}
+	else {
+		// Its tile may have been rebuilt since
+		StartPoly = Self->PathRequestQueue->GetDispatchedStartPoly(Query);
+		if (!StartPoly || !Self->GetRecastMesh() || !Self->GetRecastMesh()->isValidPolyRef(StartPoly)) {
+			StartPoly = Self->GetFlowFieldPoly(Query.StartLocation);
+		}
+	}
+
+	const FNavPathCacheKey Key(StartPoly, Self->GetFlowFieldPoly(Query.EndLocation), Query.QueryFilter.Get(), Self->GetThreatVersion());
+
+	const bool bDefaultFilter = Query.QueryFilter.Get() == Self->GetDefaultQueryFilter().Get();
+	const bool bLongRange = CLUSTER_GRAPH && FVector::Dist(Query.StartLocation, Query.EndLocation) >= FNavClusterGraph::MIN_DISTANCE;
+	FNavCachedCorridor Cached;
+
+	// Same polys, filter and threats: reuse the corridor and only string pull it again
+	if (Key.StartPoly && Key.EndPoly && Self->PathCache->Find(Key, Cached)) {
+		return BuildCorridorPath(Self, Query, Cached);
+	}
+
+	// Long paths on the cluster graph, once it has the threats of the key and the latest tiles
+	if (bLongRange && bDefaultFilter && !Self->bClusterGraphDirty && Key.StartPoly && Key.EndPoly && Self->ClusterGraph->GetFilterVersion() == Key.ThreatVersion
+		&& Self->ClusterGraph->FindCorridor(Key.StartPoly, Query.StartLocation, Key.EndPoly, Query.EndLocation, Cached.Corridor, Cached.CorridorCost)) {
+		Self->PathCache->Add(Key, Cached);
+		FPathFindingResult Result = BuildCorridorPath(Self, Query, Cached);
+		// Queued paths are tracked when the queue gets them back
+		if (INCREMENTAL_REPLANNING && IsInGameThread() && Cast<const AController>(Query.Owner.Get())) {
+			// The planner of a previous short move does not go there
+			Self->AgentPlanners.FindOrAdd(Query.Owner).Planner.Reset();
+			Self->TrackAgentPath(Query.Owner.Get(), Result.Path);
+		}
+		return Result;
+	}
+
+	FPathFindingResult Result;
+	if (THREAT_AREAS) {
+		Result = ARecastNavMesh::FindPath(AgentProperties, Query);
+	}
+	else {
+		FPathFindingQuery ThreatQuery(Query);
+		ThreatQuery.QueryFilter = Query.QueryFilter->GetCopy();
+		Result = ARecastNavMesh::FindPath(AgentProperties, ThreatQuery);
+	}
+
+	// Only complete paths are cached
+	const FNavMeshPath* FoundPath = Result.Path.IsValid() ? Result.Path->CastPath<FNavMeshPath>() : NULL;
+	if (Key.StartPoly && Key.EndPoly && Result.IsSuccessful() && !Result.IsPartial() && FoundPath && FoundPath->PathCorridor.Num() > 0) {
+		FNavCachedCorridor Corridor;
+		Corridor.Corridor = FoundPath->PathCorridor;
+		Corridor.CorridorCost = FoundPath->PathCorridorCost;
+		Self->PathCache->Add(Key, Corridor);
+	}
+	return Result;
+}
+
+const FNavPathCache& AMyRecastNavMesh::GetPathCache() const {
+	return *PathCache;
+}
+
+const FNavClusterGraph& AMyRecastNavMesh::GetClusterGraph() const {
+	return *ClusterGraph;
+}
+
+FNavPathRequestQueue& AMyRecastNavMesh::GetPathRequestQueue() {
+	return *PathRequestQueue;
+}
+
+bool AMyRecastNavMesh::FindIncrementalPath(const FPathFindingQuery& Query, const dtPolyRef StartPoly, FPathFindingResult& OutResult) const {
+	check(IsInGameThread());
+	if (!INCREMENTAL_REPLANNING || !StartPoly || !Query.QueryFilter.IsValid() || Query.QueryFilter.Get() != GetDefaultQueryFilter().Get()
+		|| !Cast<const AController>(Query.Owner.Get())) {
+		return false;
+	}
+	// Long moves go through the cluster graph
+	if (CLUSTER_GRAPH && FVector::Dist(Query.StartLocation, Query.EndLocation) >= FNavClusterGraph::MIN_DISTANCE) {
+		return false;
+	}
+	const dtPolyRef EndPoly = GetFlowFieldPoly(Query.EndLocation);
+	FNavCachedCorridor Corridor;
+	if (!EndPoly || !FindIncrementalCorridor(Query, StartPoly, EndPoly, Corridor)) {
+		return false;
+	}
+	OutResult = BuildCorridorPath(this, Query, Corridor);
+	TrackAgentPath(Query.Owner.Get(), OutResult.Path);
+	return true;
+}
+
+bool AMyRecastNavMesh::FindIncrementalCorridor(const FPathFindingQuery& Query, const dtPolyRef StartPoly, const dtPolyRef EndPoly, FNavCachedCorridor& OutCorridor) const {
+	const dtNavMesh* DetourMesh = GetRecastMesh();
+	if (!DetourMesh || !GetCustomFilter()) {
+		return false;
+	}
+
+	const uint32 Version = GetThreatVersion();
+	const FBox2D ThreatBounds = GetThreatBounds();
+	FAgentPlanner* AgentPlanner = AgentPlanners.Find(Query.Owner);
+	if (!AgentPlanner || !AgentPlanner->Planner.IsValid() || AgentPlanner->Planner->GetGoalPoly() != EndPoly) {
+		// New destination, new search
+		AgentPlanner = &AgentPlanners.Add(Query.Owner);
+		AgentPlanner->Planner = MakeShareable(new FNavIncrementalPlanner(DetourMesh, CreateThreatFilter(), StartPoly, EndPoly, Version));
+		AgentPlanner->ThreatBounds = ThreatBounds;
+	}
+	else {
+		if (AgentPlanner->Planner->GetFilterVersion() != Version) {
+			// Costs only changed where the player saw before or sees now
+			FBox2D ChangedArea = AgentPlanner->ThreatBounds;
+			ChangedArea += ThreatBounds;
+			AgentPlanner->Planner->UpdateFilter(CreateThreatFilter(), Version, ChangedArea);
+			AgentPlanner->ThreatBounds = ThreatBounds;
+		}
+		AgentPlanner->Planner->SetStart(StartPoly);
+	}
+	return AgentPlanner->Planner->GetCorridor(OutCorridor.Corridor, OutCorridor.CorridorCost);
+}
+
+void AMyRecastNavMesh::TrackAgentPath(const UObject* Owner, const FNavPathSharedPtr& Path) const {
+	// Paths from the cluster graph have no planner, their repath goes through the graph again
+	FAgentPlanner& AgentPlanner = AgentPlanners.FindOrAdd(Owner);
+	if (!AgentPlanner.Planner.IsValid()) {
+		AgentPlanner.ThreatBounds = GetThreatBounds();
+	}
+	AgentPlanner.Path = Path;
+	AgentPlanner.PathBounds = FBox2D(0);
+	const TArray<FNavPathPoint>& PathPoints = Path->GetPathPoints();
+	for (int32 Index = 0; Index < PathPoints.Num(); ++Index) {
+		AgentPlanner.PathBounds += FVector2D(PathPoints[Index].Location.X, PathPoints[Index].Location.Y);
+	}
+}
+
+void AMyRecastNavMesh::OnQueuedPathFound(const UObject* Owner, const FNavPathSharedPtr& Path) {
+	if (INCREMENTAL_REPLANNING && Cast<const AController>(Owner)) {
+		// Found without the planner, which may go somewhere else
+		AgentPlanners.FindOrAdd(Owner).Planner.Reset();
+		TrackAgentPath(Owner, Path);
+	}
+}
+
+void AMyRecastNavMesh::InvalidateAgentPaths() {
+	const uint32 Version = GetThreatVersion();
+	if (Version == AgentPlannersVersion) {
+		return;
+	}
+	AgentPlannersVersion = Version;
+
+	const FBox2D ThreatBounds = GetThreatBounds();
+	for (auto It = AgentPlanners.CreateIterator(); It; ++It) {
+		if (!It.Key().IsValid()) {
+			It.RemoveCurrent();
+			continue;
+		}
+		FBox2D ChangedArea = It.Value().ThreatBounds;
+		ChangedArea += ThreatBounds;
+		const FNavPathSharedPtr Path = It.Value().Path.Pin();
+		if (Path.IsValid() && Path->IsValid() && ChangedArea.bIsValid && ChangedArea.Intersect(It.Value().PathBounds)) {
+			// Repaths through FindPath with the same owner, which repairs its planner
+			Path->Invalidate();
+		}
+		if (!It.Value().Planner.IsValid()) {
+			It.Value().ThreatBounds = ThreatBounds;
+		}
+	}
+}
+
+FBox2D AMyRecastNavMesh::GetThreatBounds() const {
+	const FThreatFieldPtr ThreatField = ThreatPublisher->GetLatest();
+	if (ThreatField.IsValid() && ThreatField->PlayerVisibility.IsValid()) {
+		return ThreatField->PlayerVisibility->GetBounds();
+	}
+	return FBox2D(0);
+}
+
+TSharedPtr<FRecastQueryFilter_Example> AMyRecastNavMesh::CreateThreatFilter() const {
+	TSharedPtr<FRecastQueryFilter_Example> ThreatFilter = MakeShareable(new FRecastQueryFilter_Example(*GetCustomFilter()));
+	ThreatFilter->CaptureThreatField();
+	return ThreatFilter;
+}
+
+TSharedPtr<FRecastQueryFilter_Example> AMyRecastNavMesh::CreateBaseFilter() const {
+	TSharedPtr<FRecastQueryFilter_Example> BaseFilter = MakeShareable(new FRecastQueryFilter_Example(*GetCustomFilter()));
+	BaseFilter->SetThreatPublisher(FThreatFieldPublisherPtr());
+	return BaseFilter;
+}
+
+uint32 AMyRecastNavMesh::GetThreatVersion() const {
+	if (THREAT_AREAS) {
+		return ThreatAreasVersion;
+	}
+	const FThreatFieldPtr ThreatField = ThreatPublisher->GetLatest();
+	return ThreatField.IsValid() ? ThreatField->Version : 0;
+}
+
+bool AMyRecastNavMesh::UpdateThreatAreas() {
+	const FThreatFieldPtr ThreatField = ThreatPublisher->GetLatest();
+	const uint32 Version = ThreatField.IsValid() ? ThreatField->Version : 0;
+	dtNavMesh* DetourMesh = GetRecastMesh();
+	if (Version == ThreatAreasVersion || !DetourMesh) {
+		return true;
+	}
+
+	const int32 ExposedArea = GetAreaID(UNavArea_Exposed::StaticClass());
+	const int32 PartiallyExposedArea = GetAreaID(UNavArea_PartiallyExposed::StaticClass());
+	if (ExposedArea == INDEX_NONE || PartiallyExposedArea == INDEX_NONE) {
+		return true;
+	}
+
+	// setPolyArea is not atomic for the worker threads reading the polys. The queue is the only source of async
+	// queries and its callbacks run on the game thread, so nothing in flight means no worker reads the areas
+	if (PathRequestQueue->GetNumInFlight() > 0) {
+		// Slow queries must not stall the dispatch, the retag is tried again once the released frame is over
+		if (++ThreatAreasHeldFrames > MAX_THREAT_AREAS_HOLD_FRAMES) {
+			ThreatAreasHeldFrames = 0;
+			return true;
+		}
+		return false;
+	}
+	ThreatAreasHeldFrames = 0;
+
+	// Areas of the polys seen in this version
+	TMap<dtPolyRef, uint8> NewAreas;
+	if (ThreatField.IsValid() && ThreatField->PlayerVisibility.IsValid()) {
+		const FBox2D& FanBounds = ThreatField->PlayerVisibility->GetBounds();
+		const dtNavMesh* ConstDetourMesh = DetourMesh;
+		for (int32 TileIndex = 0; TileIndex < ConstDetourMesh->getMaxTiles(); ++TileIndex) {
+			const dtMeshTile* Tile = ConstDetourMesh->getTile(TileIndex);
+			if (!Tile || !Tile->header) {
+				continue;
+			}
+			// Recast to Unreal coordinates
+			const FBox2D TileBounds = FBox2D(FVector2D(-Tile->header->bmax[0], -Tile->header->bmax[2]), FVector2D(-Tile->header->bmin[0], -Tile->header->bmin[2]));
+			if (!TileBounds.Intersect(FanBounds)) {
+				continue;
+			}
+
+			const dtPolyRef BaseRef = ConstDetourMesh->getPolyRefBase(Tile);
+			for (int32 PolyIndex = 0; PolyIndex < Tile->header->polyCount; ++PolyIndex) {
+				const dtPoly* Poly = &Tile->polys[PolyIndex];
+				if (Poly->getType() != DT_POLYTYPE_GROUND || Poly->getArea() == RECAST_NULL_AREA) {
+					continue;
+				}
+				const dtPolyRef PolyRef = BaseRef | (dtPolyRef)PolyIndex;
+				const float VisibleFraction = ThreatField->GetPolyVisibleFraction(PolyRef, Tile, Poly);
+				if (VisibleFraction > 0) {
+					NewAreas.Add(PolyRef, VisibleFraction >= EXPOSED_POLY_FRACTION ? ExposedArea : PartiallyExposedArea);
+				}
+			}
+		}
+	}
+
+	// The whole version is flipped at once with the workers idle, so queries never see half of it
+	for (auto It = ThreatTaggedPolys.CreateIterator(); It; ++It) {
+		if (!NewAreas.Contains(It.Key())) {
+			DetourMesh->setPolyArea(It.Key(), It.Value());
+			It.RemoveCurrent();
+		}
+	}
+	for (auto It = NewAreas.CreateConstIterator(); It; ++It) {
+		if (!ThreatTaggedPolys.Contains(It.Key())) {
+			unsigned char OriginalArea;
+			if (dtStatusFailed(DetourMesh->getPolyArea(It.Key(), &OriginalArea))) {
+				continue;
+			}
+			ThreatTaggedPolys.Add(It.Key(), OriginalArea);
+		}
+		DetourMesh->setPolyArea(It.Key(), It.Value());
+	}
+	ThreatAreasVersion = Version;
+	return true;
+}
+
+dtPolyRef AMyRecastNavMesh::GetFlowFieldPoly(const FVector Location) const {
+	FNavLocation Projected;
+	if (!ProjectPoint(Location, Projected, FLOW_FIELD_QUERY_EXTENT)) {
+		return 0;
+	}
+	return Projected.NodeRef;
+}
+
+TSharedPtr<const FNavFlowField> AMyRecastNavMesh::GetFlowField(const FVector Source) {
+	const dtPolyRef SourcePoly = GetFlowFieldPoly(Source);
+	FRecastQueryFilter_Example* CustomFilter = GetCustomFilter();
+	if (!SourcePoly || !CustomFilter) {
+		return NULL;
+	}
+
+	// Costs change with the threat field (or with the tagged areas)
+	const uint32 Version = GetThreatVersion();
+
+	for (int32 Index = FlowFields.Num() - 1; Index >= 0; --Index) {
+		const TSharedPtr<const FNavFlowField> FlowField = FlowFields[Index];
+		if (FlowField->GetSourcePoly() == SourcePoly && FlowField->GetFilterVersion() == Version) {
+			FlowFields.RemoveAt(Index);
+			FlowFields.Add(FlowField);
+			return FlowField;
+		}
+	}
+
+	TSharedPtr<FNavFlowField> FlowField = MakeShareable(new FNavFlowField(SourcePoly, Source, Version));
+	FlowField->Build(GetRecastMesh(), CreateThreatFilter());
+
+	if (FlowFields.Num() >= MAX_FLOW_FIELDS) {
+		FlowFields.RemoveAt(0);
+	}
+	FlowFields.Add(FlowField);
+	return FlowField;
+}
+
+void AMyRecastNavMesh::PublishPlayerVisibility(const TSharedPtr<const FVisibilityFan, ESPMode::ThreadSafe>& PlayerVisibility) {
+	ThreatPublisher->Publish(PlayerVisibility);
+}
+
+const FThreatFieldPublisherPtr& AMyRecastNavMesh::GetThreatPublisher() const {
+	return ThreatPublisher;
+}
+
+UCellVisibilityData* AMyRecastNavMesh::GetCellVisibility() const {
+	return CellVisibility;
+}
+
+UCoverTravelData* AMyRecastNavMesh::GetCoverTravel() const {
+	return CoverTravel;
+}
+
+UOccluderSegmentData* AMyRecastNavMesh::GetOccluders() const {
+	return Occluders;
+}
+
+const FOcclusionHeightGrid* AMyRecastNavMesh::GetOcclusionHeightGrid() const {
+	return OcclusionHeightGrid.Get();
+}
+
+const FOccupancyGrid* AMyRecastNavMesh::GetOccupancyGrid() const {
+	return OccupancyGrid.Get();
+}
+
+const FCoverAnnotationIndex& AMyRecastNavMesh::GetCoverAnnotations() const {
+	return CoverAnnotations;
+}
+
+void AMyRecastNavMesh::UpdateObserverCoverage(const APawn * Observer, const FVisibilityFan& Fan) {
+	if (!Observer || !CoverageBounds.bIsValid) {
+		return;
+	}
+
+	const int32 Team = HelperMethods::GetTeam(Observer);
+	TSharedPtr<FVisibilityCoverageGrid>* Coverage = TeamsCoverage.Find(Team);
+	if (!Coverage) {
+		Coverage = &TeamsCoverage.Add(Team, MakeShareable(new FVisibilityCoverageGrid(CoverageBounds)));
+	}
+	(*Coverage)->UpdateObserver(Observer, Fan);
+}
+
+void AMyRecastNavMesh::RemoveObserverCoverage(const APawn * Observer) {
+	for (auto It = TeamsCoverage.CreateIterator(); It; ++It) {
+		It.Value()->RemoveObserver(Observer);
+	}
+}
+
+bool AMyRecastNavMesh::IsPointCoveredByEnemies(const int32 Team, const FVector Point) const {
+	for (auto It = TeamsCoverage.CreateConstIterator(); It; ++It) {
+		if (It.Key() != Team && It.Value()->IsPointCovered(FVector2D(Point.X, Point.Y))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+float AMyRecastNavMesh::GetSegmentCoverageByEnemies(const int32 Team, const FVector From, const FVector To) const {
+	float Coverage = 0;
+	for (auto It = TeamsCoverage.CreateConstIterator(); It; ++It) {
+		if (It.Key() != Team) {
+			Coverage = FMath::Max(Coverage, It.Value()->GetSegmentCoverage(FVector2D(From.X, From.Y), FVector2D(To.X, To.Y)));
+		}
+	}
+	return Coverage;
+}
@@ -0,0 +1,9 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Navigation/NavArea_Exposed.h"
+
+UNavArea_Exposed::UNavArea_Exposed(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	DefaultCost = 1.1f;
+}
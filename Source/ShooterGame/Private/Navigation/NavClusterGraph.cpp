@@ -0,0 +1,571 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Navigation/NavClusterGraph.h"
+
+// Unreal (X, Y, Z) is Recast (-X, Z, -Y)
+static FVector RecastToUnreal(const float* RecastPoint) {
+	return FVector(-RecastPoint[0], -RecastPoint[2], RecastPoint[1]);
+}
+
+static void UnrealToRecast(const FVector Point, float* OutRecastPoint) {
+	OutRecastPoint[0] = -Point.X;
+	OutRecastPoint[1] = Point.Z;
+	OutRecastPoint[2] = -Point.Y;
+}
+
+// Appends a piece of corridor, merging the poly shared with the end of the corridor
+static void AppendCorridor(TArray<NavNodeRef>& Corridor, TArray<float>& CorridorCost, const TArray<NavNodeRef>& Piece, const TArray<float>& PieceCost) {
+	int32 First = 0;
+	if (Corridor.Num() > 0 && Piece.Num() > 0 && Corridor.Last() == Piece[0]) {
+		CorridorCost.Last() = PieceCost[0];
+		First = 1;
+	}
+	for (int32 Index = First; Index < Piece.Num(); ++Index) {
+		Corridor.Add(Piece[Index]);
+		CorridorCost.Add(PieceCost[Index]);
+	}
+}
+
+// Never more than the cost of walking from From to To, whatever the height the path goes through
+static float GetHeuristic(const FVector From, const FVector To) {
+	return FVector2D::Distance(FVector2D(From), FVector2D(To));
+}
+
+FNavClusterGraph::FNavClusterGraph()
+{
+}
+
+FNavClusterGraph::FGraph::FGraph(const dtNavMesh* DetourMesh, const TSharedPtr<const dtQueryFilter>& BaseFilter, const TSharedPtr<const dtQueryFilter>& Filter, const uint32 FilterVersion)
+	: DetourMesh(DetourMesh)
+	, BaseFilter(BaseFilter)
+	, Filter(Filter)
+	, FilterVersion(FilterVersion)
+{
+}
+
+FNavClusterGraph::FGraph::FGraph(const FGraph& Other, const TSharedPtr<const dtQueryFilter>& BaseFilter, const TSharedPtr<const dtQueryFilter>& Filter, const uint32 FilterVersion)
+	: DetourMesh(Other.DetourMesh)
+	, BaseFilter(BaseFilter)
+	, Filter(Filter)
+	, FilterVersion(FilterVersion)
+	, Clusters(Other.Clusters)
+	, Surcharges(Other.Surcharges)
+	, Entrances(Other.Entrances)
+	, FreeEntrances(Other.FreeEntrances)
+{
+}
+
+void FNavClusterGraph::Build(const dtNavMesh* DetourMesh, const TSharedPtr<const dtQueryFilter>& BaseFilter, const TSharedPtr<const dtQueryFilter>& Filter, const uint32 FilterVersion) {
+	const FGraphPtr NewGraph = MakeShareable(new FGraph(DetourMesh, BaseFilter, Filter, FilterVersion));
+	TSet<int32> Tiles;
+	for (int32 TileIndex = 0; DetourMesh && TileIndex < DetourMesh->getMaxTiles(); ++TileIndex) {
+		Tiles.Add(TileIndex);
+	}
+	Rebuild(NewGraph, Tiles, FBox2D(0));
+}
+
+void FNavClusterGraph::RebuildTiles(const dtNavMesh* DetourMesh, const TArray<uint32>& ChangedTiles, const TSharedPtr<const dtQueryFilter>& BaseFilter, const TSharedPtr<const dtQueryFilter>& Filter, const uint32 FilterVersion, const FBox2D& ChangedArea) {
+	const TSharedPtr<const FGraph, ESPMode::ThreadSafe> Current = GetGraph();
+	if (!Current.IsValid() || Current->DetourMesh != DetourMesh || Current->Clusters.Num() == 0) {
+		Build(DetourMesh, BaseFilter, Filter, FilterVersion);
+		return;
+	}
+	TSet<int32> Tiles;
+	for (int32 Index = 0; Index < ChangedTiles.Num(); ++Index) {
+		Tiles.Add((int32)ChangedTiles[Index]);
+	}
+	Rebuild(MakeShareable(new FGraph(*Current, BaseFilter, Filter, FilterVersion)), Tiles, ChangedArea);
+}
+
+void FNavClusterGraph::UpdateFilter(const TSharedPtr<const dtQueryFilter>& NewBaseFilter, const TSharedPtr<const dtQueryFilter>& NewFilter, const uint32 NewFilterVersion, const FBox2D& ChangedArea) {
+	const TSharedPtr<const FGraph, ESPMode::ThreadSafe> Current = GetGraph();
+	if (!Current.IsValid()) {
+		return;
+	}
+	Rebuild(MakeShareable(new FGraph(*Current, NewBaseFilter, NewFilter, NewFilterVersion)), TSet<int32>(), ChangedArea);
+}
+
+void FNavClusterGraph::Rebuild(const FGraphPtr& NewGraph, const TSet<int32>& ChangedTiles, const FBox2D& ChangedArea) {
+	const dtNavMesh* DetourMesh = NewGraph->DetourMesh;
+	FClusterMap Rebuilt;
+	if (DetourMesh && NewGraph->BaseFilter.IsValid() && NewGraph->Filter.IsValid()) {
+		// The entrances to the changed tiles are on polys that are gone
+		for (int32 EntranceIndex = 0; ChangedTiles.Num() > 0 && EntranceIndex < NewGraph->Entrances.Num(); ++EntranceIndex) {
+			const FClusterEntrance Entrance = NewGraph->Entrances[EntranceIndex];
+			if (Entrance.IsRemoved() || (!ChangedTiles.Contains(Entrance.Clusters[0]) && !ChangedTiles.Contains(Entrance.Clusters[1]))) {
+				continue;
+			}
+			for (int32 Side = 0; Side < 2; ++Side) {
+				if (!ChangedTiles.Contains(Entrance.Clusters[Side])) {
+					NewGraph->GetRebuiltCluster(Entrance.Clusters[Side], Rebuilt).Entrances.Remove(EntranceIndex);
+				}
+			}
+			NewGraph->RemoveEntrance(EntranceIndex);
+		}
+
+		for (auto It = ChangedTiles.CreateConstIterator(); It; ++It) {
+			NewGraph->Clusters.Remove(*It);
+			NewGraph->Surcharges.Remove(*It);
+			const dtMeshTile* Tile = DetourMesh->getTile(*It);
+			if (!Tile || !Tile->header) {
+				continue;
+			}
+			FClusterPtr Cluster = MakeShareable(new FCluster());
+			const FVector BoundsMin = RecastToUnreal(Tile->header->bmin);
+			const FVector BoundsMax = RecastToUnreal(Tile->header->bmax);
+			Cluster->Bounds = FBox2D(0);
+			Cluster->Bounds += FVector2D(BoundsMin.X, BoundsMin.Y);
+			Cluster->Bounds += FVector2D(BoundsMax.X, BoundsMax.Y);
+			Rebuilt.Add(*It, Cluster);
+		}
+
+		// Entrances of each poly, a pair of polys can share several portals but gets one entrance
+		TMap<dtPolyRef, TArray<int32>> PolyEntrances;
+		for (auto It = ChangedTiles.CreateConstIterator(); It; ++It) {
+			if (Rebuilt.Contains(*It)) {
+				NewGraph->AddTileEntrances(*It, ChangedTiles, Rebuilt, PolyEntrances);
+			}
+		}
+
+		TSet<int32> Recosted;
+		for (auto It = Rebuilt.CreateIterator(); It; ++It) {
+			NewGraph->BuildClusterEdges(It.Key(), *It.Value());
+			NewGraph->Clusters.Add(It.Key(), It.Value());
+			Recosted.Add(It.Key());
+		}
+
+		// Threat costs only changed where the player saw before or sees now, the corridors stay the same
+		if (ChangedArea.bIsValid) {
+			for (auto It = NewGraph->Clusters.CreateConstIterator(); It; ++It) {
+				if (It.Value()->Bounds.Intersect(ChangedArea)) {
+					Recosted.Add(It.Key());
+				}
+			}
+		}
+		for (auto It = Recosted.CreateConstIterator(); It; ++It) {
+			NewGraph->UpdateSurcharges(*It);
+		}
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	Graph = NewGraph;
+}
+
+TSharedPtr<const FNavClusterGraph::FGraph, ESPMode::ThreadSafe> FNavClusterGraph::GetGraph() const {
+	FScopeLock ScopeLock(&Lock);
+	return Graph;
+}
+
+bool FNavClusterGraph::IsBuilt() const {
+	const TSharedPtr<const FGraph, ESPMode::ThreadSafe> Current = GetGraph();
+	return Current.IsValid() && Current->DetourMesh && Current->Clusters.Num() > 0;
+}
+
+uint32 FNavClusterGraph::GetFilterVersion() const {
+	const TSharedPtr<const FGraph, ESPMode::ThreadSafe> Current = GetGraph();
+	return Current.IsValid() ? Current->FilterVersion : 0;
+}
+
+int32 FNavClusterGraph::GetNumClusters() const {
+	const TSharedPtr<const FGraph, ESPMode::ThreadSafe> Current = GetGraph();
+	return Current.IsValid() ? Current->Clusters.Num() : 0;
+}
+
+int32 FNavClusterGraph::GetNumEntrances() const {
+	const TSharedPtr<const FGraph, ESPMode::ThreadSafe> Current = GetGraph();
+	return Current.IsValid() ? Current->Entrances.Num() - Current->FreeEntrances.Num() : 0;
+}
+
+bool FNavClusterGraph::FindCorridor(const dtPolyRef StartPoly, const FVector StartLocation, const dtPolyRef EndPoly, const FVector EndLocation, TArray<NavNodeRef>& OutCorridor, TArray<float>& OutCorridorCost) const {
+	OutCorridor.Reset();
+	OutCorridorCost.Reset();
+	// The lock is only held to take the graph, the search runs on it while the next one is built
+	const TSharedPtr<const FGraph, ESPMode::ThreadSafe> Current = GetGraph();
+	return Current.IsValid() && Current->FindCorridor(StartPoly, StartLocation, EndPoly, EndLocation, OutCorridor, OutCorridorCost);
+}
+
+int32 FNavClusterGraph::FGraph::AddEntrance(const FClusterEntrance& Entrance) {
+	if (FreeEntrances.Num() > 0) {
+		const int32 EntranceIndex = FreeEntrances.Pop();
+		Entrances[EntranceIndex] = Entrance;
+		return EntranceIndex;
+	}
+	return Entrances.Add(Entrance);
+}
+
+void FNavClusterGraph::FGraph::RemoveEntrance(const int32 EntranceIndex) {
+	FClusterEntrance& Entrance = Entrances[EntranceIndex];
+	Entrance.Polys[0] = Entrance.Polys[1] = 0;
+	Entrance.Clusters[0] = Entrance.Clusters[1] = INDEX_NONE;
+	FreeEntrances.Add(EntranceIndex);
+}
+
+FNavClusterGraph::FCluster& FNavClusterGraph::FGraph::GetRebuiltCluster(const int32 ClusterIndex, FClusterMap& Rebuilt) const {
+	FClusterPtr* Cluster = Rebuilt.Find(ClusterIndex);
+	if (Cluster) {
+		return **Cluster;
+	}
+	const FCluster& Published = *Clusters.FindChecked(ClusterIndex);
+	FClusterPtr Copy = MakeShareable(new FCluster());
+	Copy->Bounds = Published.Bounds;
+	Copy->Entrances = Published.Entrances;
+	return *Rebuilt.Add(ClusterIndex, Copy);
+}
+
+void FNavClusterGraph::FGraph::AddTileEntrances(const int32 TileIndex, const TSet<int32>& RebuiltTiles, FClusterMap& Rebuilt, TMap<dtPolyRef, TArray<int32>>& PolyEntrances) {
+	const dtMeshTile* Tile = DetourMesh->getTile(TileIndex);
+	const dtPolyRef BaseRef = DetourMesh->getPolyRefBase(Tile);
+	for (int32 PolyIndex = 0; PolyIndex < Tile->header->polyCount; ++PolyIndex) {
+		const dtPoly* Poly = &Tile->polys[PolyIndex];
+		const dtPolyRef PolyRef = BaseRef | (dtPolyRef)PolyIndex;
+		if (Poly->getType() != DT_POLYTYPE_GROUND || !BaseFilter->passFilter(PolyRef, Tile, Poly)) {
+			continue;
+		}
+
+		for (unsigned int LinkIndex = Poly->firstLink; LinkIndex != DT_NULL_LINK; LinkIndex = Tile->links[LinkIndex].next) {
+			const dtLink& Link = Tile->links[LinkIndex];
+			const dtPolyRef NeighbourRef = Link.ref;
+			const int32 NeighbourCluster = NeighbourRef ? GetCluster(NeighbourRef) : INDEX_NONE;
+			// Each pair once, from its lowest poly when both tiles are rebuilt
+			if (NeighbourCluster == INDEX_NONE || NeighbourCluster == TileIndex || (RebuiltTiles.Contains(NeighbourCluster) && NeighbourRef < PolyRef)
+				|| (!Rebuilt.Contains(NeighbourCluster) && !Clusters.Contains(NeighbourCluster))) {
+				continue;
+			}
+
+			const dtMeshTile* NeighbourTile = NULL;
+			const dtPoly* NeighbourPoly = NULL;
+			DetourMesh->getTileAndPolyByRefUnsafe(NeighbourRef, &NeighbourTile, &NeighbourPoly);
+			if (NeighbourPoly->getType() != DT_POLYTYPE_GROUND || !BaseFilter->passFilter(NeighbourRef, NeighbourTile, NeighbourPoly)) {
+				continue;
+			}
+
+			const TArray<int32>* Existing = PolyEntrances.Find(PolyRef);
+			bool bExisting = false;
+			for (int32 Index = 0; Existing && Index < Existing->Num(); ++Index) {
+				bExisting |= Entrances[(*Existing)[Index]].Polys[1] == NeighbourRef;
+			}
+			if (bExisting) {
+				continue;
+			}
+
+			// Tile border links only cover the part of the edge shared with the neighbour
+			const FVector EdgeStart = RecastToUnreal(&Tile->verts[Poly->verts[Link.edge] * 3]);
+			const FVector EdgeEnd = RecastToUnreal(&Tile->verts[Poly->verts[(Link.edge + 1) % Poly->vertCount] * 3]);
+			const float PortalAlpha = Link.side != 0xff ? (Link.bmin + Link.bmax) / (2 * 255.f) : 0.5f;
+
+			FClusterEntrance Entrance;
+			Entrance.Position = FMath::Lerp(EdgeStart, EdgeEnd, PortalAlpha);
+			Entrance.Polys[0] = PolyRef;
+			Entrance.Polys[1] = NeighbourRef;
+			Entrance.Clusters[0] = TileIndex;
+			Entrance.Clusters[1] = NeighbourCluster;
+			const int32 EntranceIndex = AddEntrance(Entrance);
+			PolyEntrances.FindOrAdd(PolyRef).Add(EntranceIndex);
+			GetRebuiltCluster(TileIndex, Rebuilt).Entrances.Add(EntranceIndex);
+			GetRebuiltCluster(NeighbourCluster, Rebuilt).Entrances.Add(EntranceIndex);
+		}
+	}
+}
+
+int32 FNavClusterGraph::FGraph::GetCluster(const dtPolyRef PolyRef) const {
+	return DetourMesh->isValidPolyRef(PolyRef) ? (int32)DetourMesh->decodePolyIdTile(PolyRef) : INDEX_NONE;
+}
+
+float FNavClusterGraph::FGraph::GetSegmentCost(const dtQueryFilter& QueryFilter, const FVector From, const FVector To, const dtPolyRef PolyRef) const {
+	const dtMeshTile* Tile = NULL;
+	const dtPoly* Poly = NULL;
+	DetourMesh->getTileAndPolyByRefUnsafe(PolyRef, &Tile, &Poly);
+	float RecastFrom[3], RecastTo[3];
+	UnrealToRecast(From, RecastFrom);
+	UnrealToRecast(To, RecastTo);
+	return QueryFilter.getCost(RecastFrom, RecastTo, 0, NULL, NULL, PolyRef, Tile, Poly, 0, NULL, NULL);
+}
+
+void FNavClusterGraph::FGraph::SearchCluster(const dtQueryFilter& QueryFilter, const int32 Cluster, const dtPolyRef StartPoly, const FVector StartLocation, TMap<dtPolyRef, FClusterSearchNode>& OutNodes) const {
+	OutNodes.Reset();
+	FClusterSearchNode& Start = OutNodes.Add(StartPoly);
+	Start.Cost = 0;
+	Start.Parent = 0;
+	Start.Entry = StartLocation;
+
+	TArray<FSearchEntry<dtPolyRef>> OpenList;
+	OpenList.HeapPush(FSearchEntry<dtPolyRef>(0, StartPoly));
+	while (OpenList.Num() > 0) {
+		FSearchEntry<dtPolyRef> Top;
+		OpenList.HeapPop(Top);
+		const FClusterSearchNode Node = OutNodes.FindChecked(Top.Index);
+		// Entries of the open list are dropped lazily
+		if (Top.Cost > Node.Cost) {
+			continue;
+		}
+
+		const dtMeshTile* Tile = NULL;
+		const dtPoly* Poly = NULL;
+		DetourMesh->getTileAndPolyByRefUnsafe(Top.Index, &Tile, &Poly);
+		for (unsigned int LinkIndex = Poly->firstLink; LinkIndex != DT_NULL_LINK; LinkIndex = Tile->links[LinkIndex].next) {
+			const dtLink& Link = Tile->links[LinkIndex];
+			const dtPolyRef NeighbourRef = Link.ref;
+			if (!NeighbourRef || GetCluster(NeighbourRef) != Cluster) {
+				continue;
+			}
+
+			const dtMeshTile* NeighbourTile = NULL;
+			const dtPoly* NeighbourPoly = NULL;
+			DetourMesh->getTileAndPolyByRefUnsafe(NeighbourRef, &NeighbourTile, &NeighbourPoly);
+			if (NeighbourPoly->getType() != DT_POLYTYPE_GROUND || !QueryFilter.passFilter(NeighbourRef, NeighbourTile, NeighbourPoly)) {
+				continue;
+			}
+
+			const float* EdgeStart = &Tile->verts[Poly->verts[Link.edge] * 3];
+			const float* EdgeEnd = &Tile->verts[Poly->verts[(Link.edge + 1) % Poly->vertCount] * 3];
+			const FVector Portal = (RecastToUnreal(EdgeStart) + RecastToUnreal(EdgeEnd)) / 2;
+			const float Cost = Node.Cost + GetSegmentCost(QueryFilter, Node.Entry, Portal, Top.Index);
+
+			FClusterSearchNode* Neighbour = OutNodes.Find(NeighbourRef);
+			if (Neighbour && Neighbour->Cost <= Cost) {
+				continue;
+			}
+			if (!Neighbour) {
+				Neighbour = &OutNodes.Add(NeighbourRef);
+			}
+			Neighbour->Cost = Cost;
+			Neighbour->Parent = Top.Index;
+			Neighbour->Entry = Portal;
+			OpenList.HeapPush(FSearchEntry<dtPolyRef>(Cost, NeighbourRef));
+		}
+	}
+}
+
+float FNavClusterGraph::FGraph::GetSearchCost(const dtQueryFilter& QueryFilter, const TMap<dtPolyRef, FClusterSearchNode>& Nodes, const dtPolyRef PolyRef, const FVector Location) const {
+	const FClusterSearchNode* Node = Nodes.Find(PolyRef);
+	if (!Node) {
+		return BIG_NUMBER;
+	}
+	return Node->Cost + GetSegmentCost(QueryFilter, Node->Entry, Location, PolyRef);
+}
+
+bool FNavClusterGraph::FGraph::GetSearchCorridor(const dtQueryFilter& QueryFilter, const TMap<dtPolyRef, FClusterSearchNode>& Nodes, const dtPolyRef PolyRef, const FVector Location, TArray<NavNodeRef>& OutCorridor, TArray<float>& OutCorridorCost) const {
+	OutCorridor.Reset();
+	OutCorridorCost.Reset();
+	const FClusterSearchNode* Node = Nodes.Find(PolyRef);
+	if (!Node) {
+		return false;
+	}
+
+	// Walked back from PolyRef, the cost of leaving a poly is what its next poly added on entering
+	float NextCost = Node->Cost + GetSegmentCost(QueryFilter, Node->Entry, Location, PolyRef);
+	dtPolyRef Current = PolyRef;
+	while (Current) {
+		if (OutCorridor.Num() >= MAX_CLUSTER_CORRIDOR) {
+			return false;
+		}
+		const FClusterSearchNode& CurrentNode = Nodes.FindChecked(Current);
+		OutCorridor.Add(Current);
+		OutCorridorCost.Add(NextCost - CurrentNode.Cost);
+		NextCost = CurrentNode.Cost;
+		Current = CurrentNode.Parent;
+	}
+
+	const int32 Num = OutCorridor.Num();
+	for (int32 Index = 0; Index < Num / 2; ++Index) {
+		OutCorridor.Swap(Index, Num - 1 - Index);
+		OutCorridorCost.Swap(Index, Num - 1 - Index);
+	}
+	return true;
+}
+
+void FNavClusterGraph::FGraph::BuildClusterEdges(const int32 ClusterIndex, FCluster& Cluster) const {
+	Cluster.Edges.Reset();
+
+	TMap<dtPolyRef, FClusterSearchNode> Nodes;
+	for (int32 FromIndex = 0; FromIndex < Cluster.Entrances.Num(); ++FromIndex) {
+		const FClusterEntrance& From = Entrances[Cluster.Entrances[FromIndex]];
+		SearchCluster(*BaseFilter, ClusterIndex, From.GetPolyIn(ClusterIndex), From.Position, Nodes);
+
+		for (int32 ToIndex = 0; ToIndex < Cluster.Entrances.Num(); ++ToIndex) {
+			if (ToIndex == FromIndex) {
+				continue;
+			}
+			const FClusterEntrance& To = Entrances[Cluster.Entrances[ToIndex]];
+			FClusterEdge Edge;
+			Edge.From = Cluster.Entrances[FromIndex];
+			Edge.To = Cluster.Entrances[ToIndex];
+			Edge.Cost = GetSearchCost(*BaseFilter, Nodes, To.GetPolyIn(ClusterIndex), To.Position);
+			if (Edge.Cost < BIG_NUMBER && GetSearchCorridor(*BaseFilter, Nodes, To.GetPolyIn(ClusterIndex), To.Position, Edge.Corridor, Edge.CorridorCost)) {
+				for (int32 Index = 0; Index < Edge.Corridor.Num(); ++Index) {
+					Edge.CorridorEntries.Add(Nodes.FindChecked(Edge.Corridor[Index]).Entry);
+				}
+				Cluster.Edges.Add(Edge);
+			}
+		}
+	}
+}
+
+void FNavClusterGraph::FGraph::UpdateSurcharges(const int32 ClusterIndex) {
+	const FClusterPtr* Cluster = Clusters.Find(ClusterIndex);
+	if (!Cluster) {
+		Surcharges.Remove(ClusterIndex);
+		return;
+	}
+
+	TArray<float> EdgeSurcharges;
+	bool bAnyThreat = false;
+	for (auto It = (*Cluster)->Edges.CreateConstIterator(); It; ++It) {
+		// Same segments the base cost was summed over, the last one ends at the entrance left through
+		float Cost = 0;
+		for (int32 Index = 0; Index < It->Corridor.Num(); ++Index) {
+			const FVector Exit = Index + 1 < It->Corridor.Num() ? It->CorridorEntries[Index + 1] : Entrances[It->To].Position;
+			Cost += GetSegmentCost(*Filter, It->CorridorEntries[Index], Exit, It->Corridor[Index]);
+		}
+		const float Surcharge = Cost - It->Cost;
+		EdgeSurcharges.Add(Surcharge);
+		bAnyThreat |= Surcharge != 0;
+	}
+
+	if (bAnyThreat) {
+		Surcharges.Add(ClusterIndex, MakeShareable(new TArray<float>(EdgeSurcharges)));
+	}
+	else {
+		Surcharges.Remove(ClusterIndex);
+	}
+}
+
+float FNavClusterGraph::FGraph::GetSurcharge(const int32 ClusterIndex, const int32 EdgeIndex) const {
+	const FSurchargesPtr* EdgeSurcharges = Surcharges.Find(ClusterIndex);
+	return EdgeSurcharges ? (**EdgeSurcharges)[EdgeIndex] : 0;
+}
+
+bool FNavClusterGraph::FGraph::FindCorridor(const dtPolyRef StartPoly, const FVector StartLocation, const dtPolyRef EndPoly, const FVector EndLocation, TArray<NavNodeRef>& OutCorridor, TArray<float>& OutCorridorCost) const {
+	if (!DetourMesh || !Filter.IsValid()) {
+		return false;
+	}
+	const int32 StartCluster = GetCluster(StartPoly);
+	const int32 EndCluster = GetCluster(EndPoly);
+	if (StartCluster == EndCluster || !Clusters.Contains(StartCluster) || !Clusters.Contains(EndCluster)) {
+		return false;
+	}
+
+	// The start and end clusters are searched poly by poly, from both ends (costs go both ways)
+	TMap<dtPolyRef, FClusterSearchNode> StartNodes;
+	TMap<dtPolyRef, FClusterSearchNode> EndNodes;
+	SearchCluster(*Filter, StartCluster, StartPoly, StartLocation, StartNodes);
+	SearchCluster(*Filter, EndCluster, EndPoly, EndLocation, EndNodes);
+
+	// A* on the entrances, with the 2D distance left as heuristic
+	TMap<int32, FEntranceSearchNode> Nodes;
+	TArray<FSearchEntry<int32>> OpenList;
+	const FCluster& Start = *Clusters.FindChecked(StartCluster);
+	for (int32 Index = 0; Index < Start.Entrances.Num(); ++Index) {
+		const int32 EntranceIndex = Start.Entrances[Index];
+		const FClusterEntrance& Entrance = Entrances[EntranceIndex];
+		const float Cost = GetSearchCost(*Filter, StartNodes, Entrance.GetPolyIn(StartCluster), Entrance.Position);
+		if (Cost >= BIG_NUMBER) {
+			continue;
+		}
+		FEntranceSearchNode& Node = Nodes.Add(EntranceIndex);
+		Node.Cost = Cost;
+		Node.ParentCluster = INDEX_NONE;
+		Node.ParentEdge = INDEX_NONE;
+		OpenList.HeapPush(FSearchEntry<int32>(Cost + GetHeuristic(Entrance.Position, EndLocation), EntranceIndex));
+	}
+
+	// The goal is an entry of the open list with INDEX_NONE, through the best entrance of the end cluster
+	float GoalCost = BIG_NUMBER;
+	int32 GoalEntrance = INDEX_NONE;
+	bool bFound = false;
+	while (OpenList.Num() > 0) {
+		FSearchEntry<int32> Top;
+		OpenList.HeapPop(Top);
+		if (Top.Index == INDEX_NONE) {
+			if (Top.Cost <= GoalCost) {
+				bFound = true;
+				break;
+			}
+			continue;
+		}
+
+		const FEntranceSearchNode Node = Nodes.FindChecked(Top.Index);
+		const FClusterEntrance& Entrance = Entrances[Top.Index];
+		if (Top.Cost > Node.Cost + GetHeuristic(Entrance.Position, EndLocation)) {
+			continue;
+		}
+
+		for (int32 Side = 0; Side < 2; ++Side) {
+			const int32 ClusterIndex = Entrance.Clusters[Side];
+			if (ClusterIndex == EndCluster) {
+				const float Cost = Node.Cost + GetSearchCost(*Filter, EndNodes, Entrance.Polys[Side], Entrance.Position);
+				if (Cost < GoalCost) {
+					GoalCost = Cost;
+					GoalEntrance = Top.Index;
+					OpenList.HeapPush(FSearchEntry<int32>(Cost, INDEX_NONE));
+				}
+			}
+
+			const FCluster& Cluster = *Clusters.FindChecked(ClusterIndex);
+			for (int32 EdgeIndex = 0; EdgeIndex < Cluster.Edges.Num(); ++EdgeIndex) {
+				const FClusterEdge& Edge = Cluster.Edges[EdgeIndex];
+				if (Edge.From != Top.Index) {
+					continue;
+				}
+				const float Cost = Node.Cost + Edge.Cost + GetSurcharge(ClusterIndex, EdgeIndex);
+				FEntranceSearchNode* Next = Nodes.Find(Edge.To);
+				if (Next && Next->Cost <= Cost) {
+					continue;
+				}
+				if (!Next) {
+					Next = &Nodes.Add(Edge.To);
+				}
+				Next->Cost = Cost;
+				Next->ParentCluster = ClusterIndex;
+				Next->ParentEdge = EdgeIndex;
+				OpenList.HeapPush(FSearchEntry<int32>(Cost + GetHeuristic(Entrances[Edge.To].Position, EndLocation), Edge.To));
+			}
+		}
+	}
+	if (!bFound) {
+		return false;
+	}
+
+	// Edges from the goal entrance back to the one left the start cluster through
+	TArray<const FClusterEdge*> PathEdges;
+	TArray<float> PathSurcharges;
+	int32 FirstEntrance = GoalEntrance;
+	while (true) {
+		const FEntranceSearchNode& Node = Nodes.FindChecked(FirstEntrance);
+		if (Node.ParentCluster == INDEX_NONE) {
+			break;
+		}
+		const FClusterEdge& Edge = Clusters.FindChecked(Node.ParentCluster)->Edges[Node.ParentEdge];
+		PathEdges.Add(&Edge);
+		PathSurcharges.Add(GetSurcharge(Node.ParentCluster, Node.ParentEdge));
+		FirstEntrance = Edge.From;
+	}
+
+	TArray<NavNodeRef> Piece;
+	TArray<float> PieceCost;
+	const FClusterEntrance& First = Entrances[FirstEntrance];
+	if (!GetSearchCorridor(*Filter, StartNodes, First.GetPolyIn(StartCluster), First.Position, Piece, PieceCost)) {
+		return false;
+	}
+	AppendCorridor(OutCorridor, OutCorridorCost, Piece, PieceCost);
+
+	// The entrance polys of consecutive clusters are neighbours
+	for (int32 Index = PathEdges.Num() - 1; Index >= 0; --Index) {
+		AppendCorridor(OutCorridor, OutCorridorCost, PathEdges[Index]->Corridor, PathEdges[Index]->CorridorCost);
+		OutCorridorCost.Last() += PathSurcharges[Index];
+	}
+
+	const FClusterEntrance& Last = Entrances[GoalEntrance];
+	if (!GetSearchCorridor(*Filter, EndNodes, Last.GetPolyIn(EndCluster), Last.Position, Piece, PieceCost)) {
+		return false;
+	}
+	// Searched from the end, reversed
+	const int32 Num = Piece.Num();
+	for (int32 Index = 0; Index < Num / 2; ++Index) {
+		Piece.Swap(Index, Num - 1 - Index);
+		PieceCost.Swap(Index, Num - 1 - Index);
+	}
+	AppendCorridor(OutCorridor, OutCorridorCost, Piece, PieceCost);
+	return OutCorridor.Num() > 0 && OutCorridor[0] == StartPoly && OutCorridor.Last() == EndPoly;
+}
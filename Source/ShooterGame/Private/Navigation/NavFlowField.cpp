@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Navigation/NavFlowField.h"
+
+// Unreal (X, Y, Z) is Recast (-X, Z, -Y)
+static FVector RecastToUnreal(const float* RecastPoint) {
+	return FVector(-RecastPoint[0], -RecastPoint[2], RecastPoint[1]);
+}
+
+static void UnrealToRecast(const FVector Point, float* OutRecastPoint) {
+	OutRecastPoint[0] = -Point.X;
+	OutRecastPoint[1] = Point.Z;
+	OutRecastPoint[2] = -Point.Y;
+}
+
+struct FFlowOpenNode {
+	dtPolyRef PolyRef;
+	float Cost;
+
+	FFlowOpenNode() : PolyRef(0), Cost(0) {}
+	FFlowOpenNode(const dtPolyRef PolyRef, const float Cost) : PolyRef(PolyRef), Cost(Cost) {}
+
+	bool operator<(const FFlowOpenNode& Other) const {
+		return Cost < Other.Cost;
+	}
+};
+
+FNavFlowField::FNavFlowField(const dtPolyRef SourcePoly, const FVector SourceLocation, const uint32 FilterVersion)
+	: SourcePoly(SourcePoly)
+	, SourceLocation(SourceLocation)
+	, FilterVersion(FilterVersion)
+	, DetourMesh(NULL)
+{
+}
+
+dtPolyRef FNavFlowField::GetSourcePoly() const {
+	return SourcePoly;
+}
+
+uint32 FNavFlowField::GetFilterVersion() const {
+	return FilterVersion;
+}
+
+float FNavFlowField::GetSegmentCost(const FVector From, const FVector To, const dtPolyRef PolyRef) const {
+	const dtMeshTile* Tile = NULL;
+	const dtPoly* Poly = NULL;
+	if (dtStatusFailed(DetourMesh->getTileAndPolyByRef(PolyRef, &Tile, &Poly))) {
+		return BIG_NUMBER;
+	}
+	float RecastFrom[3], RecastTo[3];
+	UnrealToRecast(From, RecastFrom);
+	UnrealToRecast(To, RecastTo);
+	return Filter->getCost(RecastFrom, RecastTo, 0, NULL, NULL, PolyRef, Tile, Poly, 0, NULL, NULL);
+}
+
+void FNavFlowField::Build(const dtNavMesh* InDetourMesh, const TSharedPtr<const dtQueryFilter>& InFilter) {
+	DetourMesh = InDetourMesh;
+	Filter = InFilter;
+	Nodes.Reset();
+	if (!DetourMesh || !Filter.IsValid() || !DetourMesh->isValidPolyRef(SourcePoly)) {
+		return;
+	}
+
+	FFlowNode& Source = Nodes.Add(SourcePoly);
+	Source.Cost = 0;
+	Source.Length = 0;
+	Source.Parent = 0;
+	Source.Entry = SourceLocation;
+
+	TArray<FFlowOpenNode> OpenList;
+	OpenList.HeapPush(FFlowOpenNode(SourcePoly, 0));
+
+	while (OpenList.Num() > 0) {
+		FFlowOpenNode Current;
+		OpenList.HeapPop(Current);
+
+		const FFlowNode CurrentNode = Nodes.FindChecked(Current.PolyRef);
+		// Already reached with a lower cost
+		if (Current.Cost > CurrentNode.Cost) {
+			continue;
+		}
+
+		const dtMeshTile* Tile = NULL;
+		const dtPoly* Poly = NULL;
+		DetourMesh->getTileAndPolyByRefUnsafe(Current.PolyRef, &Tile, &Poly);
+
+		for (unsigned int LinkIndex = Poly->firstLink; LinkIndex != DT_NULL_LINK; LinkIndex = Tile->links[LinkIndex].next) {
+			const dtLink& Link = Tile->links[LinkIndex];
+			const dtPolyRef NeighbourRef = Link.ref;
+			if (!NeighbourRef || NeighbourRef == CurrentNode.Parent) {
+				continue;
+			}
+
+			const dtMeshTile* NeighbourTile = NULL;
+			const dtPoly* NeighbourPoly = NULL;
+			DetourMesh->getTileAndPolyByRefUnsafe(NeighbourRef, &NeighbourTile, &NeighbourPoly);
+			if (NeighbourPoly->getType() != DT_POLYTYPE_GROUND || !Filter->passFilter(NeighbourRef, NeighbourTile, NeighbourPoly)) {
+				continue;
+			}
+
+			// Enter the neighbour through the middle of the shared edge
+			const float* EdgeStart = &Tile->verts[Poly->verts[Link.edge] * 3];
+			const float* EdgeEnd = &Tile->verts[Poly->verts[(Link.edge + 1) % Poly->vertCount] * 3];
+			const FVector Entry = (RecastToUnreal(EdgeStart) + RecastToUnreal(EdgeEnd)) / 2;
+
+			const float Cost = CurrentNode.Cost + GetSegmentCost(CurrentNode.Entry, Entry, Current.PolyRef);
+			FFlowNode* Neighbour = Nodes.Find(NeighbourRef);
+			if (Neighbour && Neighbour->Cost <= Cost) {
+				continue;
+			}
+			if (!Neighbour) {
+				Neighbour = &Nodes.Add(NeighbourRef);
+			}
+			Neighbour->Cost = Cost;
+			Neighbour->Length = CurrentNode.Length + FVector::Dist(CurrentNode.Entry, Entry);
+			Neighbour->Parent = Current.PolyRef;
+			Neighbour->Entry = Entry;
+			OpenList.HeapPush(FFlowOpenNode(NeighbourRef, Cost));
+		}
+	}
+}
+
+bool FNavFlowField::IsReachable(const dtPolyRef PolyRef) const {
+	return Nodes.Contains(PolyRef);
+}
+
+float FNavFlowField::GetCost(const dtPolyRef PolyRef, const FVector Location) const {
+	const FFlowNode* Node = Nodes.Find(PolyRef);
+	if (!Node) {
+		return BIG_NUMBER;
+	}
+	return Node->Cost + GetSegmentCost(Node->Entry, Location, PolyRef);
+}
+
+float FNavFlowField::GetLength(const dtPolyRef PolyRef, const FVector Location) const {
+	const FFlowNode* Node = Nodes.Find(PolyRef);
+	if (!Node) {
+		return BIG_NUMBER;
+	}
+	return Node->Length + FVector::Dist(Node->Entry, Location);
+}
@@ -0,0 +1,306 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Navigation/NavIncrementalPlanner.h"
+
+// Unreal (X, Y, Z) is Recast (-X, Z, -Y)
+static FVector RecastToUnreal(const float* RecastPoint) {
+	return FVector(-RecastPoint[0], -RecastPoint[2], RecastPoint[1]);
+}
+
+static void UnrealToRecast(const FVector Point, float* OutRecastPoint) {
+	OutRecastPoint[0] = -Point.X;
+	OutRecastPoint[1] = Point.Z;
+	OutRecastPoint[2] = -Point.Y;
+}
+
+FNavIncrementalPlanner::FNavIncrementalPlanner(const dtNavMesh* DetourMesh, const TSharedPtr<const dtQueryFilter>& Filter, const dtPolyRef StartPoly, const dtPolyRef GoalPoly, const uint32 FilterVersion)
+	: DetourMesh(DetourMesh)
+	, Filter(Filter)
+	, FilterVersion(FilterVersion)
+	, GoalPoly(GoalPoly)
+	, StartPoly(StartPoly)
+	, LastStartPoly(StartPoly)
+	, KeyModifier(0)
+	, NumExpanded(0)
+{
+	if (!DetourMesh || !Filter.IsValid() || !DetourMesh->isValidPolyRef(StartPoly) || !DetourMesh->isValidPolyRef(GoalPoly)) {
+		return;
+	}
+	GetNode(StartPoly);
+	FPlannerNode& Goal = GetNode(GoalPoly);
+	Goal.Rhs = 0;
+	Goal.Key = CalculateKey(GoalPoly);
+	Goal.bOpen = true;
+	OpenList.HeapPush(FOpenEntry(Goal.Key, GoalPoly));
+}
+
+dtPolyRef FNavIncrementalPlanner::GetGoalPoly() const {
+	return GoalPoly;
+}
+
+uint32 FNavIncrementalPlanner::GetFilterVersion() const {
+	return FilterVersion;
+}
+
+int32 FNavIncrementalPlanner::GetNumExpanded() const {
+	return NumExpanded;
+}
+
+FNavIncrementalPlanner::FPlannerNode& FNavIncrementalPlanner::GetNode(const dtPolyRef PolyRef) {
+	FPlannerNode* Existing = Nodes.Find(PolyRef);
+	if (Existing) {
+		return *Existing;
+	}
+
+	FPlannerNode& Node = Nodes.Add(PolyRef);
+	Node.G = BIG_NUMBER;
+	Node.Rhs = BIG_NUMBER;
+	Node.Key = FVector2D(0, 0);
+	Node.bOpen = false;
+	Node.bEdgesBuilt = false;
+	Node.Position = FVector(0, 0, 0);
+	Node.Bounds = FBox2D(0);
+
+	const dtMeshTile* Tile = NULL;
+	const dtPoly* Poly = NULL;
+	DetourMesh->getTileAndPolyByRefUnsafe(PolyRef, &Tile, &Poly);
+	for (int32 VertIndex = 0; VertIndex < Poly->vertCount; ++VertIndex) {
+		const FVector Vert = RecastToUnreal(&Tile->verts[Poly->verts[VertIndex] * 3]);
+		Node.Position += Vert;
+		Node.Bounds += FVector2D(Vert.X, Vert.Y);
+	}
+	if (Poly->vertCount > 0) {
+		Node.Position /= Poly->vertCount;
+	}
+	return Node;
+}
+
+float FNavIncrementalPlanner::GetSegmentCost(const FVector From, const FVector To, const dtPolyRef PolyRef) const {
+	const dtMeshTile* Tile = NULL;
+	const dtPoly* Poly = NULL;
+	DetourMesh->getTileAndPolyByRefUnsafe(PolyRef, &Tile, &Poly);
+	float RecastFrom[3], RecastTo[3];
+	UnrealToRecast(From, RecastFrom);
+	UnrealToRecast(To, RecastTo);
+	return Filter->getCost(RecastFrom, RecastTo, 0, NULL, NULL, PolyRef, Tile, Poly, 0, NULL, NULL);
+}
+
+float FNavIncrementalPlanner::GetEdgeCost(const dtPolyRef From, const dtPolyRef To, const FVector Portal) const {
+	return GetSegmentCost(Nodes.FindChecked(From).Position, Portal, From) + GetSegmentCost(Portal, Nodes.FindChecked(To).Position, To);
+}
+
+void FNavIncrementalPlanner::BuildEdges(const dtPolyRef PolyRef) {
+	if (GetNode(PolyRef).bEdgesBuilt) {
+		return;
+	}
+
+	const dtMeshTile* Tile = NULL;
+	const dtPoly* Poly = NULL;
+	DetourMesh->getTileAndPolyByRefUnsafe(PolyRef, &Tile, &Poly);
+
+	TArray<FPlannerEdge, TInlineAllocator<6>> Edges;
+	for (unsigned int LinkIndex = Poly->firstLink; LinkIndex != DT_NULL_LINK; LinkIndex = Tile->links[LinkIndex].next) {
+		const dtLink& Link = Tile->links[LinkIndex];
+		const dtPolyRef NeighbourRef = Link.ref;
+		if (!NeighbourRef) {
+			continue;
+		}
+
+		const dtMeshTile* NeighbourTile = NULL;
+		const dtPoly* NeighbourPoly = NULL;
+		DetourMesh->getTileAndPolyByRefUnsafe(NeighbourRef, &NeighbourTile, &NeighbourPoly);
+		if (NeighbourPoly->getType() != DT_POLYTYPE_GROUND || !Filter->passFilter(NeighbourRef, NeighbourTile, NeighbourPoly)) {
+			continue;
+		}
+
+		const float* EdgeStart = &Tile->verts[Poly->verts[Link.edge] * 3];
+		const float* EdgeEnd = &Tile->verts[Poly->verts[(Link.edge + 1) % Poly->vertCount] * 3];
+
+		GetNode(NeighbourRef);
+		FPlannerEdge Edge;
+		Edge.Neighbour = NeighbourRef;
+		Edge.Portal = (RecastToUnreal(EdgeStart) + RecastToUnreal(EdgeEnd)) / 2;
+		Edge.Cost = GetEdgeCost(PolyRef, NeighbourRef, Edge.Portal);
+		Edges.Add(Edge);
+	}
+
+	FPlannerNode& Node = Nodes.FindChecked(PolyRef);
+	Node.Edges = Edges;
+	Node.bEdgesBuilt = true;
+}
+
+float FNavIncrementalPlanner::GetHeuristic(const dtPolyRef From, const dtPolyRef To) const {
+	// Every cost is at least the distance walked on the ground plane (the threat costs only measure 2D lengths)
+	return FVector2D::Distance(FVector2D(Nodes.FindChecked(From).Position), FVector2D(Nodes.FindChecked(To).Position));
+}
+
+FVector2D FNavIncrementalPlanner::CalculateKey(const dtPolyRef PolyRef) const {
+	const FPlannerNode& Node = Nodes.FindChecked(PolyRef);
+	const float MinCost = FMath::Min(Node.G, Node.Rhs);
+	if (MinCost >= BIG_NUMBER) {
+		return FVector2D(BIG_NUMBER, BIG_NUMBER);
+	}
+	return FVector2D(MinCost + GetHeuristic(StartPoly, PolyRef) + KeyModifier, MinCost);
+}
+
+void FNavIncrementalPlanner::UpdateVertex(const dtPolyRef PolyRef) {
+	if (PolyRef != GoalPoly) {
+		BuildEdges(PolyRef);
+		FPlannerNode& Node = Nodes.FindChecked(PolyRef);
+		Node.Rhs = BIG_NUMBER;
+		for (int32 EdgeIndex = 0; EdgeIndex < Node.Edges.Num(); ++EdgeIndex) {
+			const FPlannerEdge& Edge = Node.Edges[EdgeIndex];
+			Node.Rhs = FMath::Min(Node.Rhs, Edge.Cost + Nodes.FindChecked(Edge.Neighbour).G);
+		}
+	}
+
+	// Entries of the open list are dropped lazily, the key of the node tells which one is current
+	FPlannerNode& Node = Nodes.FindChecked(PolyRef);
+	Node.bOpen = false;
+	if (Node.G != Node.Rhs) {
+		Node.Key = CalculateKey(PolyRef);
+		Node.bOpen = true;
+		OpenList.HeapPush(FOpenEntry(Node.Key, PolyRef));
+	}
+}
+
+bool FNavIncrementalPlanner::ComputeShortestPath() {
+	int32 Expansions = 0;
+	while (OpenList.Num() > 0) {
+		const FOpenEntry Top = OpenList.HeapTop();
+		const FPlannerNode& TopNode = Nodes.FindChecked(Top.PolyRef);
+		if (!TopNode.bOpen || TopNode.Key != Top.Key) {
+			OpenList.HeapPopDiscard();
+			continue;
+		}
+
+		const FPlannerNode& Start = Nodes.FindChecked(StartPoly);
+		if (!(Top < FOpenEntry(CalculateKey(StartPoly), StartPoly)) && Start.G == Start.Rhs) {
+			break;
+		}
+		if (++Expansions > MAX_EXPANSIONS) {
+			return false;
+		}
+		++NumExpanded;
+		OpenList.HeapPopDiscard();
+
+		// Key is out of date (the agent moved since it was pushed)
+		const FVector2D NewKey = CalculateKey(Top.PolyRef);
+		if (Top < FOpenEntry(NewKey, Top.PolyRef)) {
+			FPlannerNode& Node = Nodes.FindChecked(Top.PolyRef);
+			Node.Key = NewKey;
+			OpenList.HeapPush(FOpenEntry(NewKey, Top.PolyRef));
+			continue;
+		}
+
+		BuildEdges(Top.PolyRef);
+		FPlannerNode& Node = Nodes.FindChecked(Top.PolyRef);
+		Node.bOpen = false;
+		TArray<dtPolyRef, TInlineAllocator<6>> Neighbours;
+		for (int32 EdgeIndex = 0; EdgeIndex < Node.Edges.Num(); ++EdgeIndex) {
+			Neighbours.Add(Node.Edges[EdgeIndex].Neighbour);
+		}
+
+		if (Node.G > Node.Rhs) {
+			// Overconsistent: the cost is settled
+			Node.G = Node.Rhs;
+		}
+		else {
+			// Underconsistent: the cost went up, it and its neighbours have to be raised
+			Node.G = BIG_NUMBER;
+			UpdateVertex(Top.PolyRef);
+		}
+		for (int32 Index = 0; Index < Neighbours.Num(); ++Index) {
+			UpdateVertex(Neighbours[Index]);
+		}
+	}
+	return true;
+}
+
+void FNavIncrementalPlanner::SetStart(const dtPolyRef NewStartPoly) {
+	if (NewStartPoly == StartPoly || !DetourMesh || !DetourMesh->isValidPolyRef(NewStartPoly)) {
+		return;
+	}
+	StartPoly = NewStartPoly;
+	GetNode(StartPoly);
+	// The keys already in the open list were computed from the previous start
+	KeyModifier += GetHeuristic(LastStartPoly, StartPoly);
+	LastStartPoly = StartPoly;
+}
+
+void FNavIncrementalPlanner::UpdateFilter(const TSharedPtr<const dtQueryFilter>& NewFilter, const uint32 NewFilterVersion, const FBox2D& ChangedArea) {
+	Filter = NewFilter;
+	FilterVersion = NewFilterVersion;
+	if (!ChangedArea.bIsValid) {
+		return;
+	}
+
+	// An edge is costed with both of its polys, so it changes if either of them is inside the area. Polys whose
+	// edges were never built still change the edges that their built predecessors have towards them
+	TArray<dtPolyRef> UpdatedPolys;
+	for (auto It = Nodes.CreateIterator(); It; ++It) {
+		FPlannerNode& Node = It.Value();
+		if (!Node.bEdgesBuilt) {
+			continue;
+		}
+		const bool NodeChanged = Node.Bounds.Intersect(ChangedArea);
+		for (int32 EdgeIndex = 0; EdgeIndex < Node.Edges.Num(); ++EdgeIndex) {
+			FPlannerEdge& Edge = Node.Edges[EdgeIndex];
+			if (!NodeChanged && !Nodes.FindChecked(Edge.Neighbour).Bounds.Intersect(ChangedArea)) {
+				continue;
+			}
+			const float Cost = GetEdgeCost(It.Key(), Edge.Neighbour, Edge.Portal);
+			if (Cost != Edge.Cost) {
+				Edge.Cost = Cost;
+				UpdatedPolys.AddUnique(It.Key());
+			}
+		}
+	}
+
+	for (int32 Index = 0; Index < UpdatedPolys.Num(); ++Index) {
+		UpdateVertex(UpdatedPolys[Index]);
+	}
+}
+
+bool FNavIncrementalPlanner::GetCorridor(TArray<NavNodeRef>& OutCorridor, TArray<float>& OutCorridorCost) {
+	OutCorridor.Reset();
+	OutCorridorCost.Reset();
+	if (!Nodes.Contains(StartPoly) || !Nodes.Contains(GoalPoly) || !ComputeShortestPath()) {
+		return false;
+	}
+	if (Nodes.FindChecked(StartPoly).G >= BIG_NUMBER) {
+		return false;
+	}
+
+	// Descend the costs to go from the start
+	dtPolyRef Current = StartPoly;
+	OutCorridor.Add(Current);
+	while (Current != GoalPoly) {
+		if (OutCorridor.Num() > Nodes.Num()) {
+			return false;
+		}
+		BuildEdges(Current);
+		const FPlannerNode& Node = Nodes.FindChecked(Current);
+		dtPolyRef Next = 0;
+		float NextCost = BIG_NUMBER;
+		float NextEdgeCost = 0;
+		for (int32 EdgeIndex = 0; EdgeIndex < Node.Edges.Num(); ++EdgeIndex) {
+			const FPlannerEdge& Edge = Node.Edges[EdgeIndex];
+			const float Cost = Edge.Cost + Nodes.FindChecked(Edge.Neighbour).G;
+			if (Cost < NextCost) {
+				Next = Edge.Neighbour;
+				NextCost = Cost;
+				NextEdgeCost = Edge.Cost;
+			}
+		}
+		if (!Next) {
+			return false;
+		}
+		OutCorridorCost.Add(NextEdgeCost);
+		OutCorridor.Add(Next);
+		Current = Next;
+	}
+	OutCorridorCost.Add(0);
+	return true;
+}
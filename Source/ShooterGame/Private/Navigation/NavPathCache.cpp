@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Navigation/NavPathCache.h"
+
+FNavPathCache::FNavPathCache(const int32 Capacity)
+	: Capacity(FMath::Max(1, Capacity))
+	, UseCounter(0)
+	, Hits(0)
+	, Misses(0)
+{
+}
+
+bool FNavPathCache::Find(const FNavPathCacheKey& Key, FNavCachedCorridor& OutCorridor) {
+	FScopeLock ScopeLock(&Lock);
+	FEntry* Entry = Entries.Find(Key);
+	if (!Entry) {
+		++Misses;
+		return false;
+	}
+	++Hits;
+	Entry->LastUse = ++UseCounter;
+	OutCorridor = Entry->Corridor;
+	return true;
+}
+
+void FNavPathCache::Add(const FNavPathCacheKey& Key, const FNavCachedCorridor& Corridor) {
+	FScopeLock ScopeLock(&Lock);
+	if (!Entries.Contains(Key) && Entries.Num() >= Capacity) {
+		// Evict the least recently used
+		const FNavPathCacheKey* OldestKey = NULL;
+		uint64 OldestUse = MAX_uint64;
+		for (auto It = Entries.CreateConstIterator(); It; ++It) {
+			if (It.Value().LastUse < OldestUse) {
+				OldestUse = It.Value().LastUse;
+				OldestKey = &It.Key();
+			}
+		}
+		if (OldestKey) {
+			Entries.Remove(FNavPathCacheKey(*OldestKey));
+		}
+	}
+
+	FEntry& Entry = Entries.FindOrAdd(Key);
+	Entry.Corridor = Corridor;
+	Entry.LastUse = ++UseCounter;
+}
+
+void FNavPathCache::Empty() {
+	FScopeLock ScopeLock(&Lock);
+	Entries.Empty();
+}
+
+int32 FNavPathCache::Num() const {
+	FScopeLock ScopeLock(&Lock);
+	return Entries.Num();
+}
+
+uint32 FNavPathCache::GetHits() const {
+	FScopeLock ScopeLock(&Lock);
+	return Hits;
+}
+
+uint32 FNavPathCache::GetMisses() const {
+	FScopeLock ScopeLock(&Lock);
+	return Misses;
+}
+
+float FNavPathCache::GetHitRate() const {
+	FScopeLock ScopeLock(&Lock);
+	const uint32 Total = Hits + Misses;
+	return Total > 0 ? (float)Hits / Total : 0.0f;
+}
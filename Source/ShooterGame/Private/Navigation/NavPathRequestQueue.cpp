@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Navigation/NavPathRequestQueue.h"
+
+FNavPathRequestQueue::FNavPathRequestQueue()
+	: NumCoalesced(0)
+	, NextOrder(0)
+{
+}
+
+void FNavPathRequestQueue::Enqueue(const UObject* Owner, const FNavAgentProperties& AgentProperties, const FPathFindingQuery& Query, const NavNodeRef StartPoly, const int32 Priority) {
+	for (int32 Index = 0; Index < Pending.Num(); ++Index) {
+		FQueuedPathRequest& Request = Pending[Index];
+		if (Request.Owner.Get() == Owner) {
+			// Only the latest move of an agent matters, the path following is not waiting for the old one anymore
+			Request.AgentProperties = AgentProperties;
+			Request.Query = Query;
+			Request.StartPoly = StartPoly;
+			Request.Priority = FMath::Max(Request.Priority, Priority);
+			++NumCoalesced;
+			return;
+		}
+	}
+	Pending.Add(FQueuedPathRequest(Owner, AgentProperties, Query, StartPoly, Priority, NextOrder++));
+}
+
+void FNavPathRequestQueue::Cancel(const UObject* Owner) {
+	for (int32 Index = Pending.Num() - 1; Index >= 0; --Index) {
+		if (Pending[Index].Owner.Get() == Owner) {
+			Pending.RemoveAt(Index);
+		}
+	}
+	// Its worker still runs, only the result is dropped
+	FScopeLock ScopeLock(&DispatchedLock);
+	for (int32 Index = 0; Index < Dispatched.Num(); ++Index) {
+		if (Dispatched[Index].Owner.Get() == Owner) {
+			Dispatched[Index].Owner = NULL;
+		}
+	}
+}
+
+void FNavPathRequestQueue::Process(UNavigationSystem* NavSys) {
+	if (!NavSys) {
+		return;
+	}
+
+	// Requests of agents that are gone
+	Pending.RemoveAll([](const FQueuedPathRequest& Request) {
+		return !Request.Owner.IsValid() || !Request.Query.PathInstanceToFill.IsValid();
+	});
+
+	Pending.Sort([](const FQueuedPathRequest& A, const FQueuedPathRequest& B) {
+		return A.Priority > B.Priority || (A.Priority == B.Priority && A.Order < B.Order);
+	});
+
+	int32 NumDispatched = 0;
+	while (Pending.Num() > 0 && NumDispatched < MAX_DISPATCH_PER_FRAME && GetNumInFlight() < MAX_IN_FLIGHT) {
+		FQueuedPathRequest Request = Pending[0];
+		Pending.RemoveAt(0);
+
+		// Registered before the worker can look for its start poly
+		const FNavigationPath* Path = Request.Query.PathInstanceToFill.Get();
+		{
+			FScopeLock ScopeLock(&DispatchedLock);
+			Dispatched.Add(FDispatchedPathRequest(Request.Owner, Path, Request.StartPoly));
+		}
+
+		const uint32 QueryID = NavSys->FindPathAsync(Request.AgentProperties, Request.Query, FNavPathQueryDelegate::CreateSP(this, &FNavPathRequestQueue::OnPathFound));
+		if (QueryID == INVALID_NAVQUERYID) {
+			{
+				FScopeLock ScopeLock(&DispatchedLock);
+				Dispatched.RemoveAll([Path](const FDispatchedPathRequest& Entry) { return Entry.Path == Path; });
+			}
+			Request.Query.PathInstanceToFill->RePathFailed();
+			continue;
+		}
+		++NumDispatched;
+	}
+}
+
+void FNavPathRequestQueue::OnPathFound(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path) {
+	TWeakObjectPtr<const UObject> Owner;
+	{
+		FScopeLock ScopeLock(&DispatchedLock);
+		for (int32 Index = 0; Index < Dispatched.Num(); ++Index) {
+			if (Dispatched[Index].Path == Path.Get()) {
+				Owner = Dispatched[Index].Owner;
+				Dispatched.RemoveAt(Index);
+				break;
+			}
+		}
+	}
+	// Cancelled or its agent is gone
+	if (!Path.IsValid() || !Owner.IsValid()) {
+		return;
+	}
+	// The path following waits for this path, tell it the path is ready
+	if (Result == ENavigationQueryResult::Success && Path->IsValid()) {
+		OnQueuedPathFound.ExecuteIfBound(Owner.Get(), Path);
+		Path->DoneUpdating(ENavPathUpdateType::NavigationChanged);
+	}
+	else {
+		Path->RePathFailed();
+	}
+}
+
+int32 FNavPathRequestQueue::GetNumPending() const {
+	return Pending.Num();
+}
+
+int32 FNavPathRequestQueue::GetNumInFlight() const {
+	FScopeLock ScopeLock(&DispatchedLock);
+	return Dispatched.Num();
+}
+
+int32 FNavPathRequestQueue::GetNumCoalesced() const {
+	return NumCoalesced;
+}
+
+NavNodeRef FNavPathRequestQueue::GetDispatchedStartPoly(const FPathFindingQuery& Query) const {
+	const FNavigationPath* Path = Query.PathInstanceToFill.Get();
+	if (!Path) {
+		return 0;
+	}
+	FScopeLock ScopeLock(&DispatchedLock);
+	for (int32 Index = 0; Index < Dispatched.Num(); ++Index) {
+		if (Dispatched[Index].Path == Path) {
+			return Dispatched[Index].StartPoly;
+		}
+	}
+	return 0;
+}
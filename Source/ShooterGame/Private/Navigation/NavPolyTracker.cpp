@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Runtime/Navmesh/Public/Detour/DetourNavMesh.h"
+#include "Runtime/Navmesh/Public/Detour/DetourCommon.h"
+#include "Public/Navigation/NavPolyTracker.h"
+
+// Unreal (X, Y, Z) is Recast (-X, Z, -Y)
+static void UnrealToRecast(const FVector Point, float* OutRecastPoint) {
+	OutRecastPoint[0] = -Point.X;
+	OutRecastPoint[1] = Point.Z;
+	OutRecastPoint[2] = -Point.Y;
+}
+
+FNavPolyTracker::FNavPolyTracker()
+	: CurrentPoly(0)
+	, NumCoherentHits(0)
+	, NumSpatialQueries(0)
+{
+}
+
+bool FNavPolyTracker::GetPolyHeight(const dtMeshTile* Tile, const dtPoly* Poly, const FVector Location, float& OutHeight) {
+	float RecastLocation[3];
+	UnrealToRecast(Location, RecastLocation);
+	// Navmesh polys are convex, a fan from the first vertex covers them
+	const float* First = &Tile->verts[Poly->verts[0] * 3];
+	for (int32 VertIndex = 1; VertIndex + 1 < Poly->vertCount; ++VertIndex) {
+		const float* Second = &Tile->verts[Poly->verts[VertIndex] * 3];
+		const float* Third = &Tile->verts[Poly->verts[VertIndex + 1] * 3];
+		if (dtClosestHeightPointTriangle(RecastLocation, First, Second, Third, OutHeight)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FNavPolyTracker::FindNearby(const ARecastNavMesh* NavMesh, const FVector Location, FNavLocation& OutNavLocation) const {
+	const dtNavMesh* DetourMesh = NavMesh ? NavMesh->GetRecastMesh() : NULL;
+	if (!CurrentPoly || !DetourMesh || !DetourMesh->isValidPolyRef(CurrentPoly)) {
+		return false;
+	}
+
+	const dtMeshTile* Tile = NULL;
+	const dtPoly* Poly = NULL;
+	DetourMesh->getTileAndPolyByRefUnsafe(CurrentPoly, &Tile, &Poly);
+
+	// Previous poly first, then the polys linked to it
+	TArray<NavNodeRef, TInlineAllocator<8>> Candidates;
+	Candidates.Add(CurrentPoly);
+	for (unsigned int LinkIndex = Poly->firstLink; LinkIndex != DT_NULL_LINK; LinkIndex = Tile->links[LinkIndex].next) {
+		if (Tile->links[LinkIndex].ref) {
+			Candidates.Add(Tile->links[LinkIndex].ref);
+		}
+	}
+
+	for (int32 Index = 0; Index < Candidates.Num(); ++Index) {
+		const dtMeshTile* CandidateTile = NULL;
+		const dtPoly* CandidatePoly = NULL;
+		DetourMesh->getTileAndPolyByRefUnsafe(Candidates[Index], &CandidateTile, &CandidatePoly);
+		float Height;
+		if (CandidatePoly->getType() != DT_POLYTYPE_GROUND || !GetPolyHeight(CandidateTile, CandidatePoly, Location, Height)) {
+			continue;
+		}
+		if (FMath::Abs(Height - Location.Z) <= MAX_HEIGHT_DIFF) {
+			OutNavLocation = FNavLocation(FVector(Location.X, Location.Y, Height), Candidates[Index]);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FNavPolyTracker::Update(const ARecastNavMesh* NavMesh, const FVector Location, FNavLocation& OutNavLocation) {
+	if (!NavMesh) {
+		return false;
+	}
+	if (FindNearby(NavMesh, Location, OutNavLocation)) {
+		CurrentPoly = OutNavLocation.NodeRef;
+		++NumCoherentHits;
+		return true;
+	}
+
+	++NumSpatialQueries;
+	if (!NavMesh->ProjectPoint(Location, OutNavLocation, FVector(QUERY_EXTENT_XY, QUERY_EXTENT_XY, QUERY_EXTENT_Z))) {
+		CurrentPoly = 0;
+		return false;
+	}
+	CurrentPoly = OutNavLocation.NodeRef;
+	return true;
+}
+
+void FNavPolyTracker::Reset() {
+	CurrentPoly = 0;
+}
+
+NavNodeRef FNavPolyTracker::GetCurrentPoly() const {
+	return CurrentPoly;
+}
+
+int32 FNavPolyTracker::GetNumCoherentHits() const {
+	return NumCoherentHits;
+}
+
+int32 FNavPolyTracker::GetNumSpatialQueries() const {
+	return NumSpatialQueries;
+}
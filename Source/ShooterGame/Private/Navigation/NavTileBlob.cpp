@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Navigation/NavTileBlob.h"
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX || PLATFORM_MAC
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const FString FNavTileBlob::FILE_EXTENSION = ".navtiles";
+
+FNavTileBlob::FNavTileBlob()
+	: Data(NULL)
+	, Size(0)
+	, bMapped(false)
+	, FileHandle(NULL)
+	, MappingHandle(NULL)
+{
+}
+
+FNavTileBlob::~FNavTileBlob() {
+	if (!Data) {
+		return;
+	}
+	if (!bMapped) {
+		FMemory::Free(Data);
+		return;
+	}
+#if PLATFORM_WINDOWS
+	UnmapViewOfFile(Data);
+	CloseHandle(MappingHandle);
+	CloseHandle(FileHandle);
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	munmap(Data, Size);
+#endif
+}
+
+FString FNavTileBlob::GetFileName(UWorld * World) {
+	const FString MapPackage = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+	return FPaths::GameContentDir() / TEXT("NavTiles") / FPackageName::GetShortName(MapPackage) + FILE_EXTENSION;
+}
+
+TSharedPtr<FNavTileBlob> FNavTileBlob::Map(const FString& FileName) {
+	const FString FullName = FPaths::ConvertRelativePathToFull(FileName);
+	if (!FPaths::FileExists(FullName)) {
+		return NULL;
+	}
+
+	TSharedPtr<FNavTileBlob> Blob = MakeShareable(new FNavTileBlob());
+#if PLATFORM_WINDOWS
+	// Copy on write view, detour writes the links of the tiles
+	Blob->FileHandle = CreateFileW(*FullName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (Blob->FileHandle != INVALID_HANDLE_VALUE) {
+		LARGE_INTEGER FileSize;
+		GetFileSizeEx(Blob->FileHandle, &FileSize);
+		Blob->MappingHandle = CreateFileMappingW(Blob->FileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (Blob->MappingHandle) {
+			Blob->Data = (uint8*)MapViewOfFile(Blob->MappingHandle, FILE_MAP_COPY, 0, 0, 0);
+			Blob->Size = FileSize.QuadPart;
+		}
+		if (!Blob->Data) {
+			if (Blob->MappingHandle) {
+				CloseHandle(Blob->MappingHandle);
+			}
+			CloseHandle(Blob->FileHandle);
+		}
+	}
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	const int File = open(TCHAR_TO_UTF8(*FullName), O_RDONLY);
+	if (File >= 0) {
+		struct stat FileStat;
+		if (fstat(File, &FileStat) == 0 && FileStat.st_size > 0) {
+			// Private mapping: pages are shared until detour writes them
+			void* Mapped = mmap(NULL, FileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, File, 0);
+			if (Mapped != MAP_FAILED) {
+				Blob->Data = (uint8*)Mapped;
+				Blob->Size = FileStat.st_size;
+			}
+		}
+		close(File);
+	}
+#endif
+	Blob->bMapped = Blob->Data != NULL;
+
+	// No mapping on this platform: read it, page aligned like the file
+	if (!Blob->Data) {
+		TArray<uint8> Bytes;
+		if (!FFileHelper::LoadFileToArray(Bytes, *FullName)) {
+			return NULL;
+		}
+		Blob->Size = Bytes.Num();
+		Blob->Data = (uint8*)FMemory::Malloc(Bytes.Num(), PAGE_SIZE);
+		FMemory::Memcpy(Blob->Data, Bytes.GetData(), Bytes.Num());
+	}
+
+	if (!Blob->IsValid()) {
+		UE_LOG(LogNavigation, Warning, TEXT("FNavTileBlob: %s is not valid for this build"), *FullName);
+		return NULL;
+	}
+	return Blob;
+}
+
+bool FNavTileBlob::Write(const FString& FileName, const dtNavMesh* DetourMesh) {
+	if (!DetourMesh) {
+		return false;
+	}
+
+	TArray<const dtMeshTile*> Tiles;
+	for (int32 TileIndex = 0; TileIndex < DetourMesh->getMaxTiles(); ++TileIndex) {
+		const dtMeshTile* Tile = DetourMesh->getTile(TileIndex);
+		if (Tile && Tile->header && Tile->data && Tile->dataSize > 0) {
+			Tiles.Add(Tile);
+		}
+	}
+
+	FBlobHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = MAGIC;
+	Header.Version = VERSION;
+	Header.DetourVersion = DT_NAVMESH_VERSION;
+	Header.NumTiles = Tiles.Num();
+	Header.Params = *DetourMesh->getParams();
+
+	TArray<FBlobTile> Table;
+	uint64 Offset = Align(sizeof(FBlobHeader) + Tiles.Num() * sizeof(FBlobTile), PAGE_SIZE);
+	for (int32 Index = 0; Index < Tiles.Num(); ++Index) {
+		FBlobTile& Entry = Table[Table.AddZeroed()];
+		Entry.Offset = Offset;
+		Entry.Size = Tiles[Index]->dataSize;
+		Offset = Align(Offset + Entry.Size, PAGE_SIZE);
+	}
+
+	TArray<uint8> Bytes;
+	Bytes.AddZeroed(Offset);
+	FMemory::Memcpy(Bytes.GetData(), &Header, sizeof(FBlobHeader));
+	if (Table.Num() > 0) {
+		FMemory::Memcpy(Bytes.GetData() + sizeof(FBlobHeader), Table.GetData(), Table.Num() * sizeof(FBlobTile));
+	}
+	for (int32 Index = 0; Index < Tiles.Num(); ++Index) {
+		FMemory::Memcpy(Bytes.GetData() + Table[Index].Offset, Tiles[Index]->data, Table[Index].Size);
+	}
+	return FFileHelper::SaveArrayToFile(Bytes, *FileName);
+}
+
+const FNavTileBlob::FBlobHeader& FNavTileBlob::GetHeader() const {
+	return *(const FBlobHeader*)Data;
+}
+
+const FNavTileBlob::FBlobTile& FNavTileBlob::GetTile(const int32 Index) const {
+	return ((const FBlobTile*)(Data + sizeof(FBlobHeader)))[Index];
+}
+
+bool FNavTileBlob::IsValid() const {
+	if (!Data || Size < (int64)sizeof(FBlobHeader)) {
+		return false;
+	}
+	const FBlobHeader& Header = GetHeader();
+	if (Header.Magic != MAGIC || Header.Version != VERSION || Header.DetourVersion != DT_NAVMESH_VERSION || Header.NumTiles < 0) {
+		return false;
+	}
+	if ((int64)(sizeof(FBlobHeader) + Header.NumTiles * sizeof(FBlobTile)) > Size) {
+		return false;
+	}
+	for (int32 Index = 0; Index < Header.NumTiles; ++Index) {
+		const FBlobTile& Tile = GetTile(Index);
+		if (Tile.Size < (int32)sizeof(dtMeshHeader) || Tile.Offset % PAGE_SIZE != 0 || (int64)(Tile.Offset + Tile.Size) > Size) {
+			return false;
+		}
+		const dtMeshHeader* TileHeader = (const dtMeshHeader*)(Data + Tile.Offset);
+		if (TileHeader->magic != DT_NAVMESH_MAGIC || TileHeader->version != DT_NAVMESH_VERSION) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FNavTileBlob::MatchesParams(const dtNavMeshParams& Params) const {
+	return FMemory::Memcmp(&GetHeader().Params, &Params, sizeof(dtNavMeshParams)) == 0;
+}
+
+int32 FNavTileBlob::GetNumTiles() const {
+	return GetHeader().NumTiles;
+}
+
+unsigned char* FNavTileBlob::GetTileData(const int32 Index) const {
+	return Data + GetTile(Index).Offset;
+}
+
+int32 FNavTileBlob::GetTileDataSize(const int32 Index) const {
+	return GetTile(Index).Size;
+}
+
+bool FNavTileBlob::IsMapped() const {
+	return bMapped;
+}
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Navigation/ThreatField.h"
+
+FThreatField::FThreatField(const uint32 Version, const TSharedPtr<const FVisibilityFan, ESPMode::ThreadSafe>& PlayerVisibility)
+	: Version(Version)
+	, PlayerVisibility(PlayerVisibility)
+{
+}
+
+bool FThreatField::IsPointVisible(const FVector2D Point) const {
+	return PlayerVisibility.IsValid() && PlayerVisibility->IsPointInside(Point);
+}
+
+bool FThreatField::MayBeVisible(const FBox2D& Bounds) const {
+	return PlayerVisibility.IsValid() && !PlayerVisibility->IsEmpty() && Bounds.Intersect(PlayerVisibility->GetBounds());
+}
+
+float FThreatField::GetExposedLength(const FVector2D Start, const FVector2D End) const {
+	return PlayerVisibility.IsValid() ? PlayerVisibility->GetSegmentLengthInside(Start, End) : 0;
+}
+
+float FThreatField::GetPolyVisibleFraction(const dtPolyRef PolyRef, const dtMeshTile* Tile, const dtPoly* Poly) const {
+	if (!PlayerVisibility.IsValid() || !Tile || !Poly) {
+		return 0;
+	}
+
+	{
+		FScopeLock Lock(&PolyThreatsLock);
+		const float* CachedFraction = PolyThreats.Find(PolyRef);
+		if (CachedFraction) {
+			return *CachedFraction;
+		}
+	}
+
+	// Two threads may compute the same poly, both get the same value
+	const float VisibleFraction = ComputePolyVisibleFraction(*PlayerVisibility, Tile, Poly);
+
+	FScopeLock Lock(&PolyThreatsLock);
+	PolyThreats.Add(PolyRef, VisibleFraction);
+	return VisibleFraction;
+}
+
+float FThreatField::ComputePolyVisibleFraction(const FVisibilityFan& Fan, const dtMeshTile* Tile, const dtPoly* Poly) {
+	if (Fan.IsEmpty() || Poly->vertCount == 0) {
+		return 0;
+	}
+
+	// Recast to Unreal coordinates
+	TArray<FVector2D, TInlineAllocator<DT_VERTS_PER_POLYGON>> Vertexs;
+	FBox2D PolyBounds(ForceInit);
+	FVector2D Centroid(0, 0);
+	for (int32 Index = 0; Index < Poly->vertCount; ++Index) {
+		const float* Vert = &Tile->verts[Poly->verts[Index] * 3];
+		const FVector2D Vertex = FVector2D(-Vert[0], -Vert[2]);
+		Vertexs.Add(Vertex);
+		PolyBounds += Vertex;
+		Centroid += Vertex;
+	}
+	Centroid /= Poly->vertCount;
+
+	if (!PolyBounds.Intersect(Fan.GetBounds())) {
+		return 0;
+	}
+
+	// Samples spread over the poly: centroid, vertexs, edges middle points and halfway to the centroid
+	TArray<FVector2D, TInlineAllocator<DT_VERTS_PER_POLYGON * 3 + 1>> Samples;
+	Samples.Add(Centroid);
+	for (int32 Index = 0; Index < Vertexs.Num(); ++Index) {
+		const FVector2D& Vertex = Vertexs[Index];
+		const FVector2D& NextVertex = Vertexs[(Index + 1) % Vertexs.Num()];
+		Samples.Add(Vertex);
+		Samples.Add((Vertex + NextVertex) / 2);
+		Samples.Add((Vertex + Centroid) / 2);
+	}
+
+	bool SamplesInside[DT_VERTS_PER_POLYGON * 3 + 1];
+	const int32 NumInside = Fan.ArePointsInside(Samples.GetData(), Samples.Num(), SamplesInside);
+	return (float)NumInside / Samples.Num();
+}
+
+//----------------------------------------------------------------------//
+// FThreatFieldPublisher
+//----------------------------------------------------------------------//
+
+FThreatFieldPublisher::FThreatFieldPublisher()
+	: NextVersion(1)
+{
+}
+
+void FThreatFieldPublisher::Publish(const TSharedPtr<const FVisibilityFan, ESPMode::ThreadSafe>& PlayerVisibility) {
+	FScopeLock Lock(&LatestLock);
+	if (Latest.IsValid() && Latest->PlayerVisibility == PlayerVisibility) {
+		return;
+	}
+	Latest = MakeShareable(new FThreatField(NextVersion++, PlayerVisibility));
+}
+
+FThreatFieldPtr FThreatFieldPublisher::GetLatest() const {
+	FScopeLock Lock(&LatestLock);
+	return Latest;
+}
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Others/CellVisibilityData.h"
+
+const FString UCellVisibilityData::ASSET_SUFFIX = "_Visibility";
+
+UCellVisibilityData::UCellVisibilityData(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	GridOrigin = FVector2D(0, 0);
+	CellSize = 100;
+	CellsX = 0;
+	CellsY = 0;
+	NumRows = 0;
+}
+
+FString UCellVisibilityData::GetAssetPath(UWorld * World) {
+	// Package of the map without PIE prefix, i.e. /Game/Maps/Sanctuary
+	const FString MapPackage = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+	const FString AssetName = FPackageName::GetShortName(MapPackage) + ASSET_SUFFIX;
+	return MapPackage + ASSET_SUFFIX + "." + AssetName;
+}
+
+UCellVisibilityData* UCellVisibilityData::LoadForWorld(UWorld * World) {
+	if (!World) {
+		return NULL;
+	}
+	return Cast<UCellVisibilityData>(StaticLoadObject(UCellVisibilityData::StaticClass(), NULL, *GetAssetPath(World), NULL, LOAD_NoWarn | LOAD_Quiet));
+}
+
+void UCellVisibilityData::PostLoad() {
+	Super::PostLoad();
+	ExpandRuns();
+}
+
+int32 UCellVisibilityData::GetCellIndex(const FVector Location) const {
+	const int32 X = FMath::FloorToInt((Location.X - GridOrigin.X) / CellSize);
+	const int32 Y = FMath::FloorToInt((Location.Y - GridOrigin.Y) / CellSize);
+	if (X < 0 || X >= CellsX || Y < 0 || Y >= CellsY) {
+		return INDEX_NONE;
+	}
+	return Y * CellsX + X;
+}
+
+int32 UCellVisibilityData::GetRow(const FVector Location) const {
+	const int32 CellIndex = GetCellIndex(Location);
+	return CellRows.IsValidIndex(CellIndex) ? CellRows[CellIndex] : INDEX_NONE;
+}
+
+int32 UCellVisibilityData::GetNumRows() const {
+	return NumRows;
+}
+
+bool UCellVisibilityData::GetVisibility(const FVector From, const FVector To, bool &OutVisible) const {
+	const int32 FromRow = GetRow(From);
+	const int32 ToRow = GetRow(To);
+	if (FromRow == INDEX_NONE || ToRow == INDEX_NONE || NumRows == 0) {
+		return false;
+	}
+	OutVisible = VisibilityBits[FromRow * NumRows + ToRow];
+	return true;
+}
+
+void UCellVisibilityData::SetVisibility(const TBitArray<> &VisibilityMatrix, const int32 InNumRows) {
+	check(VisibilityMatrix.Num() == InNumRows * InNumRows);
+
+	NumRows = InNumRows;
+	RowOffsets.Empty(NumRows + 1);
+	Runs.Empty();
+
+	for (int32 Row = 0; Row < NumRows; ++Row) {
+		RowOffsets.Add(Runs.Num());
+
+		bool RunValue = false;
+		int32 RunLength = 0;
+		for (int32 Column = 0; Column < NumRows; ++Column) {
+			const bool Value = VisibilityMatrix[Row * NumRows + Column];
+			if (Value != RunValue || RunLength == MAX_uint16) {
+				Runs.Add(RunLength);
+				// A run at max length is followed by an empty run of the other value
+				RunValue = !RunValue;
+				RunLength = 0;
+				if (Value != RunValue) {
+					Runs.Add(0);
+					RunValue = !RunValue;
+				}
+			}
+			++RunLength;
+		}
+		Runs.Add(RunLength);
+	}
+	RowOffsets.Add(Runs.Num());
+
+	VisibilityBits = VisibilityMatrix;
+}
+
+void UCellVisibilityData::ExpandRuns() {
+	NumRows = FMath::Max(0, RowOffsets.Num() - 1);
+	VisibilityBits.Init(false, NumRows * NumRows);
+
+	for (int32 Row = 0; Row < NumRows; ++Row) {
+		int32 Column = Row * NumRows;
+		bool RunValue = false;
+		for (int32 RunIndex = RowOffsets[Row]; RunIndex < RowOffsets[Row + 1]; ++RunIndex) {
+			const int32 RunEnd = FMath::Min(Column + Runs[RunIndex], (Row + 1) * NumRows);
+			if (RunValue) {
+				for (int32 Bit = Column; Bit < RunEnd; ++Bit) {
+					VisibilityBits[Bit] = true;
+				}
+			}
+			Column = RunEnd;
+			RunValue = !RunValue;
+		}
+	}
+}
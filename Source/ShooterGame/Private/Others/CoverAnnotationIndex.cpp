@@ -0,0 +1,184 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/EQS/CoverBaseClass.h"
+#include "Public/Others/CoverAnnotationIndex.h"
+
+FCoverAnnotationIndex::FCoverAnnotationIndex()
+	: Origin(0, 0)
+	, CellsX(0)
+	, CellsY(0)
+{
+}
+
+int32 FCoverAnnotationIndex::GetCellX(const float X) const {
+	return FMath::Clamp(FMath::FloorToInt((X - Origin.X) / CELL_SIZE), 0, CellsX - 1);
+}
+
+int32 FCoverAnnotationIndex::GetCellY(const float Y) const {
+	return FMath::Clamp(FMath::FloorToInt((Y - Origin.Y) / CELL_SIZE), 0, CellsY - 1);
+}
+
+void FCoverAnnotationIndex::Build(UWorld * World) {
+	TArray<FCoverAnnotation> Found;
+	FBox2D Bounds(0);
+	for (TActorIterator<ACoverBaseClass> It(World); It; ++It) {
+		TArray<AActor*> CoverAnnotations;
+		It->GetAttachedActors(CoverAnnotations);
+		for (auto It2 = CoverAnnotations.CreateConstIterator(); It2; ++It2) {
+			FCoverAnnotation Annotation;
+			Annotation.Location = (*It2)->GetActorLocation();
+			Annotation.CoverLocation = It->GetActorLocation();
+			Found.Add(Annotation);
+			Bounds += FVector2D(Annotation.Location.X, Annotation.Location.Y);
+		}
+	}
+
+	Annotations.Reset();
+	CellStarts.Reset();
+	if (Found.Num() == 0) {
+		CellsX = 0;
+		CellsY = 0;
+		return;
+	}
+	Origin = Bounds.Min;
+	CellsX = FMath::FloorToInt((Bounds.Max.X - Bounds.Min.X) / CELL_SIZE) + 1;
+	CellsY = FMath::FloorToInt((Bounds.Max.Y - Bounds.Min.Y) / CELL_SIZE) + 1;
+
+	// Counting sort by cell
+	TArray<int32> Cells;
+	CellStarts.Init(0, CellsX * CellsY + 1);
+	for (int32 Index = 0; Index < Found.Num(); ++Index) {
+		const int32 Cell = GetCellY(Found[Index].Location.Y) * CellsX + GetCellX(Found[Index].Location.X);
+		Cells.Add(Cell);
+		++CellStarts[Cell + 1];
+	}
+	for (int32 Cell = 0; Cell < CellsX * CellsY; ++Cell) {
+		CellStarts[Cell + 1] += CellStarts[Cell];
+	}
+	TArray<int32> Next = CellStarts;
+	Annotations.SetNum(Found.Num());
+	for (int32 Index = 0; Index < Found.Num(); ++Index) {
+		Annotations[Next[Cells[Index]]++] = Found[Index];
+	}
+}
+
+int32 FCoverAnnotationIndex::Num() const {
+	return Annotations.Num();
+}
+
+const FCoverAnnotationIndex::FCoverAnnotation& FCoverAnnotationIndex::GetAnnotation(const int32 Index) const {
+	return Annotations[Index];
+}
+
+void FCoverAnnotationIndex::FindInRadius(const FVector Location, const float Radius, TArray<int32> &OutAnnotations) const {
+	OutAnnotations.Reset();
+	if (Annotations.Num() == 0) {
+		return;
+	}
+
+	const float RadiusSquared = FMath::Square(Radius);
+	const int32 MinX = GetCellX(Location.X - Radius);
+	const int32 MaxX = GetCellX(Location.X + Radius);
+	const int32 MinY = GetCellY(Location.Y - Radius);
+	const int32 MaxY = GetCellY(Location.Y + Radius);
+	for (int32 Y = MinY; Y <= MaxY; ++Y) {
+		// The cells of a row are consecutive
+		const int32 RowStart = CellStarts[Y * CellsX + MinX];
+		const int32 RowEnd = CellStarts[Y * CellsX + MaxX + 1];
+		for (int32 Index = RowStart; Index < RowEnd; ++Index) {
+			if (FVector::DistSquared(Location, Annotations[Index].Location) <= RadiusSquared) {
+				OutAnnotations.Add(Index);
+			}
+		}
+	}
+}
+
+int32 FCoverAnnotationIndex::FindNearest(const FVector Location, const float MaxDistance) const {
+	if (Annotations.Num() == 0) {
+		return INDEX_NONE;
+	}
+
+	float NearestDistSquared = FMath::Square(MaxDistance);
+	int32 NearestIndex = INDEX_NONE;
+	const int32 CenterX = GetCellX(Location.X);
+	const int32 CenterY = GetCellY(Location.Y);
+	const int32 MaxRing = FMath::Max(CellsX, CellsY);
+	for (int32 Ring = 0; Ring <= MaxRing; ++Ring) {
+		// Anything in this ring or farther is at least (Ring - 1) cells away
+		if (Ring > 1 && FMath::Square((Ring - 1) * (float)CELL_SIZE) > NearestDistSquared) {
+			break;
+		}
+		for (int32 Y = CenterY - Ring; Y <= CenterY + Ring; ++Y) {
+			if (Y < 0 || Y >= CellsY) {
+				continue;
+			}
+			// Inner rows of the ring only have their two border cells
+			const int32 StepX = (Y == CenterY - Ring || Y == CenterY + Ring) ? 1 : FMath::Max(2 * Ring, 1);
+			for (int32 X = CenterX - Ring; X <= CenterX + Ring; X += StepX) {
+				if (X < 0 || X >= CellsX) {
+					continue;
+				}
+				const int32 Cell = Y * CellsX + X;
+				for (int32 Index = CellStarts[Cell]; Index < CellStarts[Cell + 1]; ++Index) {
+					const float DistSquared = FVector::DistSquared(Location, Annotations[Index].Location);
+					if (DistSquared <= NearestDistSquared) {
+						NearestDistSquared = DistSquared;
+						NearestIndex = Index;
+					}
+				}
+			}
+		}
+	}
+	return NearestIndex;
+}
+
+void FCoverAnnotationIndex::FindNearest(const FVector Location, const float MaxDistance, const int32 K, TArray<int32> &OutAnnotations) const {
+	OutAnnotations.Reset();
+	const int32 NumNearest = FMath::Min(K, (int32)MAX_NEAREST);
+	if (Annotations.Num() == 0 || NumNearest <= 0) {
+		return;
+	}
+
+	// Closest first, the last one is the farthest kept
+	TArray<float, TInlineAllocator<MAX_NEAREST>> NearestDistSquared;
+	const float MaxDistSquared = FMath::Square(MaxDistance);
+	const int32 CenterX = GetCellX(Location.X);
+	const int32 CenterY = GetCellY(Location.Y);
+	const int32 MaxRing = FMath::Max(CellsX, CellsY);
+	for (int32 Ring = 0; Ring <= MaxRing; ++Ring) {
+		const float BoundDistSquared = NearestDistSquared.Num() == NumNearest ? NearestDistSquared.Last() : MaxDistSquared;
+		if (Ring > 1 && FMath::Square((Ring - 1) * (float)CELL_SIZE) > BoundDistSquared) {
+			break;
+		}
+		for (int32 Y = CenterY - Ring; Y <= CenterY + Ring; ++Y) {
+			if (Y < 0 || Y >= CellsY) {
+				continue;
+			}
+			const int32 StepX = (Y == CenterY - Ring || Y == CenterY + Ring) ? 1 : FMath::Max(2 * Ring, 1);
+			for (int32 X = CenterX - Ring; X <= CenterX + Ring; X += StepX) {
+				if (X < 0 || X >= CellsX) {
+					continue;
+				}
+				const int32 Cell = Y * CellsX + X;
+				for (int32 Index = CellStarts[Cell]; Index < CellStarts[Cell + 1]; ++Index) {
+					const float DistSquared = FVector::DistSquared(Location, Annotations[Index].Location);
+					if (DistSquared > MaxDistSquared || (NearestDistSquared.Num() == NumNearest && DistSquared >= NearestDistSquared.Last())) {
+						continue;
+					}
+					// Insertion in the sorted list, dropping the farthest when it is full
+					if (NearestDistSquared.Num() == NumNearest) {
+						NearestDistSquared.Pop(false);
+						OutAnnotations.Pop(false);
+					}
+					int32 Position = NearestDistSquared.Num();
+					while (Position > 0 && NearestDistSquared[Position - 1] > DistSquared) {
+						--Position;
+					}
+					NearestDistSquared.Insert(DistSquared, Position);
+					OutAnnotations.Insert(Index, Position);
+				}
+			}
+		}
+	}
+}
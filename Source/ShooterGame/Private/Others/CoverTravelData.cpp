@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Others/CoverTravelData.h"
+
+const FString UCoverTravelData::ASSET_SUFFIX = "_CoverTravel";
+
+UCoverTravelData::UCoverTravelData(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	NumCovers = 0;
+	WalkSpeed = 600;
+	TimeStep = 0.01f;
+}
+
+FString UCoverTravelData::GetAssetPath(UWorld * World) {
+	// Package of the map without PIE prefix, i.e. /Game/Maps/Sanctuary
+	const FString MapPackage = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+	const FString AssetName = FPackageName::GetShortName(MapPackage) + ASSET_SUFFIX;
+	return MapPackage + ASSET_SUFFIX + "." + AssetName;
+}
+
+UCoverTravelData* UCoverTravelData::LoadForWorld(UWorld * World) {
+	if (!World) {
+		return NULL;
+	}
+	return Cast<UCoverTravelData>(StaticLoadObject(UCoverTravelData::StaticClass(), NULL, *GetAssetPath(World), NULL, LOAD_NoWarn | LOAD_Quiet));
+}
+
+void UCoverTravelData::PostLoad() {
+	Super::PostLoad();
+	BuildWaypointCells();
+}
+
+int32 UCoverTravelData::GetNumWaypoints() const {
+	return Waypoints.Num();
+}
+
+FIntPoint UCoverTravelData::GetCell(const FVector Location) const {
+	return FIntPoint(FMath::FloorToInt(Location.X / SNAP_DISTANCE), FMath::FloorToInt(Location.Y / SNAP_DISTANCE));
+}
+
+void UCoverTravelData::BuildWaypointCells() {
+	WaypointCells.Reset();
+	for (int32 Index = 0; Index < Waypoints.Num(); ++Index) {
+		WaypointCells.FindOrAdd(GetCell(Waypoints[Index])).Add(Index);
+	}
+}
+
+int32 UCoverTravelData::FindWaypoint(const FVector Location) const {
+	// Anything within SNAP_DISTANCE is in the cell of the location or a neighbour one
+	const FIntPoint Cell = GetCell(Location);
+	int32 Closest = INDEX_NONE;
+	float ClosestDistSquared = FMath::Square((float)SNAP_DISTANCE);
+	for (int32 Y = Cell.Y - 1; Y <= Cell.Y + 1; ++Y) {
+		for (int32 X = Cell.X - 1; X <= Cell.X + 1; ++X) {
+			const TArray<int32>* CellWaypoints = WaypointCells.Find(FIntPoint(X, Y));
+			for (int32 Index = 0; CellWaypoints && Index < CellWaypoints->Num(); ++Index) {
+				const float DistSquared = FVector::DistSquared(Location, Waypoints[(*CellWaypoints)[Index]]);
+				if (DistSquared <= ClosestDistSquared) {
+					Closest = (*CellWaypoints)[Index];
+					ClosestDistSquared = DistSquared;
+				}
+			}
+		}
+	}
+	return Closest;
+}
+
+float UCoverTravelData::GetTravelTime(const int32 FromWaypoint, const int32 ToWaypoint) const {
+	const uint16 Time = TravelTimes[FromWaypoint * Waypoints.Num() + ToWaypoint];
+	return Time == UNREACHABLE ? BIG_NUMBER : Time * TimeStep;
+}
+
+bool UCoverTravelData::IsWaypointReachable(const ANavigationData* NavData, const FVector Location, const int32 Waypoint) const {
+	FVector HitLocation;
+	return !NavData || !NavData->Raycast(Waypoints[Waypoint], Location, HitLocation, NavData->GetDefaultQueryFilter());
+}
+
+bool UCoverTravelData::GetTravelTime(const ANavigationData* NavData, const FVector From, const FVector To, float &OutTime) const {
+	const int32 FromWaypoint = FindWaypoint(From);
+	const int32 ToWaypoint = FindWaypoint(To);
+	if (FromWaypoint == INDEX_NONE || ToWaypoint == INDEX_NONE || TravelTimes.Num() != Waypoints.Num() * Waypoints.Num()) {
+		return false;
+	}
+	if (!IsWaypointReachable(NavData, From, FromWaypoint) || !IsWaypointReachable(NavData, To, ToWaypoint)) {
+		return false;
+	}
+	OutTime = GetTravelTime(FromWaypoint, ToWaypoint);
+	if (OutTime < BIG_NUMBER) {
+		OutTime += (FVector::Dist(From, Waypoints[FromWaypoint]) + FVector::Dist(Waypoints[ToWaypoint], To)) / WalkSpeed;
+	}
+	return true;
+}
+
+void UCoverTravelData::SetTravelTimes(const TArray<float> &Times) {
+	check(Times.Num() == Waypoints.Num() * Waypoints.Num());
+
+	// The longest travel gets the highest time that is not UNREACHABLE
+	float MaxTime = 0;
+	for (int32 Index = 0; Index < Times.Num(); ++Index) {
+		if (Times[Index] < BIG_NUMBER) {
+			MaxTime = FMath::Max(MaxTime, Times[Index]);
+		}
+	}
+	TimeStep = FMath::Max(MaxTime / (UNREACHABLE - 1), 0.001f);
+
+	TravelTimes.SetNumUninitialized(Times.Num());
+	for (int32 Index = 0; Index < Times.Num(); ++Index) {
+		TravelTimes[Index] = Times[Index] < BIG_NUMBER ? (uint16)FMath::Min(FMath::RoundToInt(Times[Index] / TimeStep), UNREACHABLE - 1) : UNREACHABLE;
+	}
+	BuildWaypointCells();
+}
@@ -3,8 +3,11 @@
 #include "ShooterGame.h"
 #include "Bots/ShooterBot.h"
 #include "Bots/ShooterAIController.h"
+#include "Online/ShooterPlayerState.h"
 #include "Public/EQS/CoverBaseClass.h"
 #include "Public/Navigation/MyRecastNavMesh.h"
+#include "Public/Others/CellVisibilityData.h"
+#include "Public/Others/OccluderSegmentData.h"
 #include "Public/Others/HelperMethods.h"
 
 FVector HelperMethods::GetPlayerPositionFromAI(UWorld * World) {
@@ -84,55 +87,225 @@ FVector HelperMethods::GetPlayerForwardVectorFromAI(UWorld * World) {
 	return PlayerForwardVector;
 }
 
+AMyRecastNavMesh* HelperMethods::GetNavMesh(UWorld * World) {
+	AMyRecastNavMesh* MyNavMesh = NULL;
+	if (World) {
+		UNavigationSystem* NavSys = World->GetNavigationSystem();
+		if (NavSys) {
+			MyNavMesh = Cast<AMyRecastNavMesh>(NavSys->GetMainNavData(FNavigationSystem::DontCreate));
+		}
+	}
+	return MyNavMesh;
+}
+
+int32 HelperMethods::GetTeam(const APawn * Pawn) {
+	const UWorld * World = Pawn ? Pawn->GetWorld() : NULL;
+	const AShooterGameState* GameState = World ? Cast<AShooterGameState>(World->GameState) : NULL;
+	const AShooterPlayerState* PlayerState = Pawn ? Cast<AShooterPlayerState>(Pawn->PlayerState) : NULL;
+
+	if (GameState && GameState->NumTeams > 1 && PlayerState) {
+		return PlayerState->GetTeamNum();
+	}
+	return Cast<AShooterBot>(Pawn) ? 1 : 0;
+}
+
+bool HelperMethods::GetBakedLineOfSight(UWorld * World, const FVector From, const FVector To, bool &OutVisible, const bool RefineWithDynamic) {
+	const AMyRecastNavMesh* MyNavMesh = GetNavMesh(World);
+	const UCellVisibilityData* CellVisibility = MyNavMesh ? MyNavMesh->GetCellVisibility() : NULL;
+
+	if (CellVisibility) {
+		if (!CellVisibility->GetVisibility(From, To, OutVisible)) {
+			return false;
+		}
+	}
+	else if (!GetStanceLineOfSight(World, From, HelperMethods::EYES_POS_Z, To, HelperMethods::EYES_POS_Z, OutVisible)) {
+		return false;
+	}
+
+	if (OutVisible && RefineWithDynamic) {
+		// Static geometry does not block, something that moves still can
+		FCollisionQueryParams CollisionParams;
+		TArray<AActor*> ActorsToIgnore;
+		UGameplayStatics::GetAllActorsOfClass(World, AShooterCharacter::StaticClass(), ActorsToIgnore);
+		CollisionParams.AddIgnoredActors(ActorsToIgnore);
+
+		const FVector UpFrom = FVector(From.X, From.Y, HelperMethods::EYES_POS_Z);
+		const FVector UpTo = FVector(To.X, To.Y, HelperMethods::EYES_POS_Z);
+		OutVisible = !World->LineTraceTestByObjectType(UpFrom, UpTo, FCollisionObjectQueryParams(FCollisionObjectQueryParams::AllDynamicObjects), CollisionParams);
+	}
+	return true;
+}
+
+bool HelperMethods::GetStanceLineOfSight(UWorld * World, const FVector From, const float FromEyesZ, const FVector To, const float ToEyesZ, bool &OutVisible) {
+	const AMyRecastNavMesh* MyNavMesh = GetNavMesh(World);
+	const FOcclusionHeightGrid* OcclusionGrid = MyNavMesh ? MyNavMesh->GetOcclusionHeightGrid() : NULL;
+	if (!OcclusionGrid) {
+		return false;
+	}
+
+	OutVisible = !OcclusionGrid->IsLineOfSightBlocked(FVector(From.X, From.Y, FromEyesZ), FVector(To.X, To.Y, ToEyesZ));
+	return true;
+}
+
+ELineOfSight HelperMethods::GetGridLineOfSight(UWorld * World, const FVector From, const FVector To) {
+	const AMyRecastNavMesh* MyNavMesh = GetNavMesh(World);
+	const FOccupancyGrid* OccupancyGrid = MyNavMesh ? MyNavMesh->GetOccupancyGrid() : NULL;
+	if (!OccupancyGrid) {
+		return ELineOfSight::Uncertain;
+	}
+	// The grid is a single slice, a segment off that height crosses other collision
+	const float Height = OccupancyGrid->GetHeight();
+	if (FMath::Abs(From.Z - Height) > OFFSET || FMath::Abs(To.Z - Height) > OFFSET) {
+		return ELineOfSight::Uncertain;
+	}
+	return OccupancyGrid->GetLineOfSight(FVector2D(From.X, From.Y), FVector2D(To.X, To.Y));
+}
+
 // http://www.redblobgames.com/articles/visibility/
 // http://gamedev.stackexchange.com/questions/21897/quick-2d-sight-area-calculation-algorithm
 TArray<Triangle> HelperMethods::CalculateVisibility(UWorld * World, const FVector Location, const FVector ForwardVector, const float ViewAngle, const float ViewDistance){
 	TArray<Triangle> VisibleLocations;
 
 	if (World) {
-		//APawn * PlayerPawn = World->GetFirstPlayerController()->GetPawn();
-		
-		TArray<Triangle> VisibleTriangles;
-
-		TArray<AActor*> CubeActors;
-		TArray<Vertex> VisibleVertexs;
-
-
 		const FVector EyesLocation = FVector(Location.X, Location.Y, HelperMethods::EYES_POS_Z);
-		//FVector ForwardVector = UGameplayStatics::GetPlayerCameraManager(World, 0)->GetActorForwardVector();
 		const FVector NewForwardVector = FVector(ForwardVector.X, ForwardVector.Y, 0);
-		// Calculate max start and max end point of the player's FOV
-		const FVector EndOfFirstTrace = EyesLocation + FRotator(0, -ViewAngle, 0).RotateVector(NewForwardVector) * ViewDistance;
-		const FVector EndOfLastTrace = EyesLocation + FRotator(0, ViewAngle, 0).RotateVector(NewForwardVector) * ViewDistance;
-
-		Vertex FirstTraceVertex;
-		FirstTraceVertex.V = EndOfFirstTrace;
-		FirstTraceVertex.LeftmostVertex = true;
-		FirstTraceVertex.RightmostVertex = false;
-
-		Vertex LastTraceVertex;
-		LastTraceVertex.V = EndOfLastTrace;
-		LastTraceVertex.LeftmostVertex = false;
-		LastTraceVertex.RightmostVertex = true;
-
-		// Add them to visible vertexes
-		VisibleVertexs = HelperMethods::GetVisibleObstaclesVertexs(World, EyesLocation, NewForwardVector, ViewAngle, ViewDistance);
-		VisibleVertexs.Add(FirstTraceVertex);
-		VisibleVertexs.Add(LastTraceVertex);
-
-		// Sort the vertexs according to the angle between them and the camera, and the camera forward vector
-		HelperMethods::SortByAngle(VisibleVertexs, EyesLocation, EndOfFirstTrace);
-		VisibleLocations = HelperMethods::GetVisibleTriangles(VisibleVertexs, World, EyesLocation);
+
+		const TArray<Vertex> VisibleVertexs = HelperMethods::GetSortedFanVertexs(World, EyesLocation, NewForwardVector, ViewAngle, ViewDistance);
+		VisibleLocations = HelperMethods::GetVisibleTriangles(VisibleVertexs, World, EyesLocation, ViewAngle, ViewDistance);
 	}
 
 	return VisibleLocations;
 }
 
+//----------------------------------------------------------------------//
+// Async visibility
+//----------------------------------------------------------------------//
+
+/**
+* Keeps the state of a fan whose traces are in the async trace queue.
+* Each vertex submits one trace along its direction, as far as the vertex or the view distance (whatever is farther).
+* The first hit answers both the vertex trace and the projected trace of the sync mode. The fan is assembled when the last one arrives.
+*/
+class FVisibilityAsyncFan : public TSharedFromThis<FVisibilityAsyncFan>
+{
+public:
+	TWeakObjectPtr<UWorld> World;
+	FVector EyesLocation;
+	float ViewDistance = 0;
+	TArray<Vertex> VisibleVertexs;
+	TArray<VertexTraceResult> TraceResults;
+	int32 PendingTraces = 0;
+	FVisibilityCalculatedDelegate OnCalculated;
+
+	void OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum);
+};
+
+// Fans waiting for their traces. Owned here because the trace delegates only hold weak references
+static TArray<TSharedRef<FVisibilityAsyncFan>> PendingVisibilityFans;
+
+void FVisibilityAsyncFan::OnTraceCompleted(const FTraceHandle& Handle, FTraceDatum& Datum) {
+	// UserData = VertexIndex
+	const int32 VertexIndex = Datum.UserData;
+	const bool BlockingHitFound = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit;
+
+	if (TraceResults.IsValidIndex(VertexIndex)) {
+		FVector TraceDirection = VisibleVertexs[VertexIndex].V - EyesLocation;
+		TraceDirection.Normalize();
+		const float VertexDistance = FVector::Dist(EyesLocation, VisibleVertexs[VertexIndex].V + TraceDirection * HelperMethods::OFFSET);
+		const float HitDistance = BlockingHitFound ? FVector::Dist(EyesLocation, Datum.OutHits[0].ImpactPoint) : BIG_NUMBER;
+
+		VertexTraceResult& Result = TraceResults[VertexIndex];
+		Result.VertexBlocked = HitDistance <= VertexDistance;
+		Result.VertexHit = Result.VertexBlocked ? Datum.OutHits[0].ImpactPoint : Datum.End;
+		Result.Projected = HitDistance <= ViewDistance ? Datum.OutHits[0].ImpactPoint : EyesLocation + TraceDirection * ViewDistance;
+	}
+
+	if (--PendingTraces == 0) {
+		TArray<Triangle> VisibleTriangles = HelperMethods::AssembleVisibleTriangles(VisibleVertexs, TraceResults, EyesLocation);
+		OnCalculated.ExecuteIfBound(VisibleTriangles);
+		PendingVisibilityFans.Remove(AsShared());
+	}
+}
+
+void HelperMethods::CalculateVisibilityAsync(UWorld * World, const FVector Location, const FVector ForwardVector, const FVisibilityCalculatedDelegate OnCalculated, const float ViewAngle, const float ViewDistance) {
+	if (!World) {
+		return;
+	}
+
+	// Drop fans of worlds that have been torn down before their traces came back
+	PendingVisibilityFans.RemoveAll([](const TSharedRef<FVisibilityAsyncFan>& Fan) {
+		return !Fan->World.IsValid();
+	});
+
+	const FVector EyesLocation = FVector(Location.X, Location.Y, HelperMethods::EYES_POS_Z);
+	const FVector NewForwardVector = FVector(ForwardVector.X, ForwardVector.Y, 0);
+
+	TSharedRef<FVisibilityAsyncFan> Fan = MakeShareable(new FVisibilityAsyncFan());
+	Fan->World = World;
+	Fan->EyesLocation = EyesLocation;
+	Fan->ViewDistance = ViewDistance;
+	Fan->OnCalculated = OnCalculated;
+	Fan->VisibleVertexs = HelperMethods::GetSortedFanVertexs(World, EyesLocation, NewForwardVector, ViewAngle, ViewDistance);
+	Fan->TraceResults.SetNum(Fan->VisibleVertexs.Num());
+	Fan->PendingTraces = Fan->VisibleVertexs.Num();
+	PendingVisibilityFans.Add(Fan);
+
+	const FCollisionQueryParams CollisionParams = GetVisibilityTraceParams(World);
+	FTraceDelegate TraceDelegate = FTraceDelegate::CreateSP(Fan, &FVisibilityAsyncFan::OnTraceCompleted);
+
+	for (int32 Index = 0; Index < Fan->VisibleVertexs.Num(); ++Index) {
+		FVector TraceDirection = Fan->VisibleVertexs[Index].V - EyesLocation;
+		TraceDirection.Normalize();
+
+		// Both traces of the sync mode go along the same ray, the first hit answers them
+		const float VertexDistance = FVector::Dist(EyesLocation, Fan->VisibleVertexs[Index].V + TraceDirection * HelperMethods::OFFSET);
+		const FVector TraceEnd = EyesLocation + TraceDirection * FMath::Max(VertexDistance, ViewDistance);
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Single, EyesLocation, TraceEnd, ECollisionChannel::ECC_Visibility, CollisionParams, FCollisionResponseParams::DefaultResponseParam, &TraceDelegate, Index);
+	}
+
+	if (Fan->PendingTraces == 0) {
+		TArray<Triangle> NoTriangles;
+		Fan->OnCalculated.ExecuteIfBound(NoTriangles);
+		PendingVisibilityFans.Remove(Fan);
+	}
+}
+
+TArray<Vertex> HelperMethods::GetSortedFanVertexs(UWorld * World, const FVector EyesLocation, const FVector ForwardVector, const float ViewAngle, const float ViewDistance) {
+	// Calculate max start and max end point of the player's FOV
+	const FVector EndOfFirstTrace = EyesLocation + FRotator(0, -ViewAngle, 0).RotateVector(ForwardVector) * ViewDistance;
+	const FVector EndOfLastTrace = EyesLocation + FRotator(0, ViewAngle, 0).RotateVector(ForwardVector) * ViewDistance;
+
+	Vertex FirstTraceVertex;
+	FirstTraceVertex.V = EndOfFirstTrace;
+	FirstTraceVertex.LeftmostVertex = true;
+	FirstTraceVertex.RightmostVertex = false;
+
+	Vertex LastTraceVertex;
+	LastTraceVertex.V = EndOfLastTrace;
+	LastTraceVertex.LeftmostVertex = false;
+	LastTraceVertex.RightmostVertex = true;
+
+	// Add them to visible vertexes
+	TArray<Vertex> VisibleVertexs = HelperMethods::GetVisibleObstaclesVertexs(World, EyesLocation, ForwardVector, ViewAngle, ViewDistance);
+	VisibleVertexs.Add(FirstTraceVertex);
+	VisibleVertexs.Add(LastTraceVertex);
+
+	// Sort the vertexs according to the angle between them and the camera, and the camera forward vector
+	HelperMethods::SortByAngle(VisibleVertexs, EyesLocation, EndOfFirstTrace);
+	return VisibleVertexs;
+}
+
 TArray<Vertex> HelperMethods::GetVisibleObstaclesVertexs(UWorld * World, const FVector EyesLocation, const FVector ForwardVector, const float ViewAngle, const float ViewDistance) {
 	//UE_LOG(LogTemp, Log, TEXT("F:GetVisibleObstaclesVertexs"));
 	TArray<AActor*> CubeActors;
 	TArray<Vertex> VisibleVertexs;
 
+	const AMyRecastNavMesh* MyNavMesh = GetNavMesh(World);
+	const UOccluderSegmentData* Occluders = MyNavMesh ? MyNavMesh->GetOccluders() : NULL;
+	if (Occluders) {
+		return GetVisibleOccludersVertexs(Occluders, EyesLocation, ForwardVector, ViewAngle, ViewDistance);
+	}
+
 	// Get All Boxes that are inside the FOV of the player
 	UGameplayStatics::GetAllActorsOfClass(World, ACoverBaseClass::StaticClass(), CubeActors);
 	for (auto It = CubeActors.CreateConstIterator(); It; ++It) {
@@ -195,6 +368,44 @@ TArray<Vertex> HelperMethods::GetVisibleObstaclesVertexs(UWorld * World, const F
 	return VisibleVertexs;
 }
 
+TArray<Vertex> HelperMethods::GetVisibleOccludersVertexs(const UOccluderSegmentData * Occluders, const FVector EyesLocation, const FVector ForwardVector, const float ViewAngle, const float ViewDistance) {
+	TArray<Vertex> VisibleVertexs;
+	const FVector2D Eyes = FVector2D(EyesLocation.X, EyesLocation.Y);
+
+	for (int32 Loop = 0; Loop < Occluders->GetNumLoops(); ++Loop) {
+		// Ignore obstacles shorter than Eye pos and the ones out of reach
+		if (!Occluders->LoopBlocksAtHeight(Loop, HelperMethods::EYES_POS_Z) || Occluders->LoopBounds[Loop].ComputeSquaredDistanceToPoint(Eyes) > ViewDistance * ViewDistance) {
+			continue;
+		}
+
+		const int32 Start = Occluders->GetLoopStart(Loop);
+		const int32 Num = Occluders->GetLoopNum(Loop);
+		for (int32 Index = 0; Index < Num; ++Index) {
+			const FVector2D Point = Occluders->Points[Start + Index];
+			const FVector V = FVector(Point.X, Point.Y, HelperMethods::EYES_POS_Z);
+
+			const float Angle = FMath::RadiansToDegrees(acosf((V - EyesLocation).CosineAngle2D(ForwardVector)));
+			if (Angle >= ViewAngle || FVector::Dist(V, EyesLocation) >= ViewDistance) { // Outside Player's FOV
+				continue;
+			}
+
+			// Silhouette vertexs have both neighbors on the same side of the eyes ray (the ray goes on past them)
+			const FVector2D Direction = Point - Eyes;
+			const float CrossPrevious = FVector2D::CrossProduct(Direction, Occluders->Points[Start + (Index + Num - 1) % Num] - Eyes);
+			const float CrossNext = FVector2D::CrossProduct(Direction, Occluders->Points[Start + (Index + 1) % Num] - Eyes);
+
+			Vertex vertex;
+			vertex.V = V;
+			vertex.LeftmostVertex = CrossPrevious > 0 && CrossNext > 0;
+			vertex.RightmostVertex = CrossPrevious < 0 && CrossNext < 0;
+
+			VisibleVertexs.Add(vertex);
+		}
+	}
+
+	return VisibleVertexs;
+}
+
 void HelperMethods::SortByAngle(TArray<Vertex> &FVectorArray, const FVector EyesLocation, const FVector EndOfFirstTrace)  {
 	//UE_LOG(LogTemp, Log, TEXT("F:SortByAngle"));
 
@@ -213,20 +424,12 @@ void HelperMethods::SortByAngle(TArray<Vertex> &FVectorArray, const FVector Eyes
 	});
 }
 
-TArray<Triangle> HelperMethods::GetVisibleTriangles(const TArray<Vertex> VisibleVertexs, UWorld * World, const FVector EyesLocation, const float ViewAngle, const float ViewDistance) {
+TArray<Triangle> HelperMethods::GetVisibleTriangles(const TArray<Vertex> &VisibleVertexs, UWorld * World, const FVector EyesLocation, const float ViewAngle, const float ViewDistance) {
 	//UE_LOG(LogTemp, Log, TEXT("F:CalculateVisibleTriangles"));
-	TArray<Triangle> VisibleTriangles;
+	TArray<VertexTraceResult> TraceResults;
 	FHitResult OutHit;
-	FCollisionQueryParams CollisionParams;
-	TArray<AActor*> ActorsToIgnore;
-	//@todo debug
-	//const FName TraceTag("VisibilityTrace");
-	//World->DebugDrawTraceTag = TraceTag;
-	//CollisionParams.TraceTag = TraceTag;
-	UGameplayStatics::GetAllActorsOfClass(World, AShooterCharacter::StaticClass(), ActorsToIgnore);
-	CollisionParams.AddIgnoredActors(ActorsToIgnore);
+	const FCollisionQueryParams CollisionParams = GetVisibilityTraceParams(World);
 
-	FVector PreviousVertex = FVector(0, 0, 0);
 	for (auto It = VisibleVertexs.CreateConstIterator(); It; ++It) {
 		const Vertex Vertex = *It;
 		FVector TraceDirection = Vertex.V - EyesLocation;
@@ -234,40 +437,45 @@ TArray<Triangle> HelperMethods::GetVisibleTriangles(const TArray<Vertex> Visible
 
 		const FVector Offset = TraceDirection * HelperMethods::OFFSET;
 		const FVector MaxProjectedVertex = EyesLocation + TraceDirection * ViewDistance;
-		const bool BlockingHitFound = World->LineTraceSingleByChannel(OutHit, EyesLocation, Vertex.V + Offset, ECollisionChannel::ECC_Visibility, CollisionParams);
+
+		VertexTraceResult Result;
+		Result.VertexBlocked = World->LineTraceSingleByChannel(OutHit, EyesLocation, Vertex.V + Offset, ECollisionChannel::ECC_Visibility, CollisionParams);
+		if (Result.VertexBlocked) {
+			Result.VertexHit = OutHit.ImpactPoint;
+		}
+		else {
+			// Projected trace only needed when the vertex is not hidden
+			const bool ProjectedBlockingHitFound = World->LineTraceSingleByChannel(OutHit, EyesLocation, MaxProjectedVertex, ECollisionChannel::ECC_Visibility, CollisionParams);
+			Result.Projected = ProjectedBlockingHitFound ? OutHit.ImpactPoint : OutHit.TraceEnd;
+		}
+		TraceResults.Add(Result);
+	}
+	return AssembleVisibleTriangles(VisibleVertexs, TraceResults, EyesLocation);
+}
+
+TArray<Triangle> HelperMethods::AssembleVisibleTriangles(const TArray<Vertex> &VisibleVertexs, const TArray<VertexTraceResult> &TraceResults, const FVector EyesLocation) {
+	TArray<Triangle> VisibleTriangles;
+
+	FVector PreviousVertex = FVector(0, 0, 0);
+	for (int32 Index = 0; Index < VisibleVertexs.Num() && Index < TraceResults.Num(); ++Index) {
+		const Vertex Vertex = VisibleVertexs[Index];
+		const VertexTraceResult Result = TraceResults[Index];
+
 		// Only First Trace
-		if (PreviousVertex == FVector(0, 0, 0)) {
-			if (BlockingHitFound) {
-				PreviousVertex = OutHit.ImpactPoint;
-			}
-			else {
-				const bool ProjectedBlockingHitFound = World->LineTraceSingleByChannel(OutHit, EyesLocation, MaxProjectedVertex, ECollisionChannel::ECC_Visibility, CollisionParams);
-				if (ProjectedBlockingHitFound) {
-					PreviousVertex = OutHit.ImpactPoint; // NOPE
-				}
-				else {
-					PreviousVertex = OutHit.TraceEnd;
-				}
-			}
+		if (Index == 0) {
+			PreviousVertex = Result.VertexBlocked ? Result.VertexHit : Result.Projected;
 		}
 		else {
 			Triangle triangle = Triangle();
 			triangle.V2 = EyesLocation;
 			triangle.V3 = PreviousVertex;
 
-			if (BlockingHitFound) {
-				triangle.V1 = OutHit.ImpactPoint;
+			if (Result.VertexBlocked) {
+				triangle.V1 = Result.VertexHit;
 				PreviousVertex = triangle.V1;
 			}
 			else {
-				const bool ProjectedBlockingHitFound = World->LineTraceSingleByChannel(OutHit, EyesLocation, MaxProjectedVertex, ECollisionChannel::ECC_Visibility, CollisionParams);
-				FVector ProjectedVertex;
-				if (ProjectedBlockingHitFound) {
-					ProjectedVertex = OutHit.ImpactPoint;
-				}
-				else {
-					ProjectedVertex = OutHit.TraceEnd;
-				}
+				const FVector ProjectedVertex = Result.Projected;
 
 				if (Vertex.LeftmostVertex) {
 					triangle.V1 = ProjectedVertex;
@@ -288,6 +496,18 @@ TArray<Triangle> HelperMethods::GetVisibleTriangles(const TArray<Vertex> Visible
 	}
 	return VisibleTriangles;
 }
+
+FCollisionQueryParams HelperMethods::GetVisibilityTraceParams(UWorld * World) {
+	FCollisionQueryParams CollisionParams;
+	TArray<AActor*> ActorsToIgnore;
+	//@todo debug
+	//const FName TraceTag("VisibilityTrace");
+	//World->DebugDrawTraceTag = TraceTag;
+	//CollisionParams.TraceTag = TraceTag;
+	UGameplayStatics::GetAllActorsOfClass(World, AShooterCharacter::StaticClass(), ActorsToIgnore);
+	CollisionParams.AddIgnoredActors(ActorsToIgnore);
+	return CollisionParams;
+}
 /*
 TArray<FVector> HelperMethods::GetLocationOfCoverAnnotationsWithinRadius(UWorld * World, const FVector ContextLocation, const float MaxRadius) {
 	TArray<FVector> LocationOfCoverAnnotations;
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Others/OccluderSegmentData.h"
+
+const FString UOccluderSegmentData::ASSET_SUFFIX = "_Occluders";
+
+UOccluderSegmentData::UOccluderSegmentData(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	LoopOffsets.Add(0);
+}
+
+FString UOccluderSegmentData::GetAssetPath(UWorld * World) {
+	// Package of the map without PIE prefix, i.e. /Game/Maps/Sanctuary
+	const FString MapPackage = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+	const FString AssetName = FPackageName::GetShortName(MapPackage) + ASSET_SUFFIX;
+	return MapPackage + ASSET_SUFFIX + "." + AssetName;
+}
+
+UOccluderSegmentData* UOccluderSegmentData::LoadForWorld(UWorld * World) {
+	if (!World) {
+		return NULL;
+	}
+	return Cast<UOccluderSegmentData>(StaticLoadObject(UOccluderSegmentData::StaticClass(), NULL, *GetAssetPath(World), NULL, LOAD_NoWarn | LOAD_Quiet));
+}
+
+void UOccluderSegmentData::AddLoop(const TArray<FVector2D> &Loop, const float MinZ, const float MaxZ) {
+	if (Loop.Num() < 2) {
+		return;
+	}
+
+	Points.Append(Loop);
+	LoopOffsets.Add(Points.Num());
+	LoopBounds.Add(FBox2D(Loop));
+	LoopMinZ.Add(MinZ);
+	LoopMaxZ.Add(MaxZ);
+}
+
+int32 UOccluderSegmentData::GetNumLoops() const {
+	return LoopBounds.Num();
+}
+
+int32 UOccluderSegmentData::GetLoopStart(const int32 Loop) const {
+	return LoopOffsets[Loop];
+}
+
+int32 UOccluderSegmentData::GetLoopNum(const int32 Loop) const {
+	return LoopOffsets[Loop + 1] - LoopOffsets[Loop];
+}
+
+bool UOccluderSegmentData::LoopBlocksAtHeight(const int32 Loop, const float Z) const {
+	return LoopMinZ[Loop] <= Z && Z <= LoopMaxZ[Loop];
+}
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Others/OccluderSegmentData.h"
+#include "Public/Others/OcclusionHeightGrid.h"
+
+FOcclusionHeightGrid::FOcclusionHeightGrid(const FBox2D& Bounds, const float CellSize)
+	: Origin(Bounds.Min)
+	, CellSize(FMath::Max(CellSize, 1.0f))
+{
+	const FVector2D Size = Bounds.GetSize();
+	CellsX = FMath::Max(1, FMath::CeilToInt(Size.X / this->CellSize));
+	CellsY = FMath::Max(1, FMath::CeilToInt(Size.Y / this->CellSize));
+	LayerMinZ.Init(BIG_NUMBER, CellsX * CellsY * MAX_LAYERS);
+	LayerMaxZ.Init(-BIG_NUMBER, CellsX * CellsY * MAX_LAYERS);
+}
+
+int32 FOcclusionHeightGrid::GetCellIndex(const FVector2D Point) const {
+	const int32 CellX = FMath::FloorToInt((Point.X - Origin.X) / CellSize);
+	const int32 CellY = FMath::FloorToInt((Point.Y - Origin.Y) / CellSize);
+	if (CellX < 0 || CellX >= CellsX || CellY < 0 || CellY >= CellsY) {
+		return INDEX_NONE;
+	}
+	return CellY * CellsX + CellX;
+}
+
+void FOcclusionHeightGrid::AddBlockingInterval(const int32 Cell, const float MinZ, const float MaxZ) {
+	float NewMinZ = MinZ;
+	float NewMaxZ = MaxZ;
+	const int32 First = Cell * MAX_LAYERS;
+
+	// Overlapping layers are merged into the new one
+	int32 FreeLayer = INDEX_NONE;
+	for (int32 Layer = First; Layer < First + MAX_LAYERS; ++Layer) {
+		if (LayerMinZ[Layer] > LayerMaxZ[Layer]) {
+			FreeLayer = (FreeLayer == INDEX_NONE) ? Layer : FreeLayer;
+		}
+		else if (LayerMinZ[Layer] <= NewMaxZ && NewMinZ <= LayerMaxZ[Layer]) {
+			NewMinZ = FMath::Min(NewMinZ, LayerMinZ[Layer]);
+			NewMaxZ = FMath::Max(NewMaxZ, LayerMaxZ[Layer]);
+			LayerMinZ[Layer] = BIG_NUMBER;
+			LayerMaxZ[Layer] = -BIG_NUMBER;
+			FreeLayer = (FreeLayer == INDEX_NONE) ? Layer : FreeLayer;
+		}
+	}
+
+	if (FreeLayer == INDEX_NONE) {
+		// No room for another layer: grow the closest one (conservative, it blocks more)
+		float ClosestGap = BIG_NUMBER;
+		for (int32 Layer = First; Layer < First + MAX_LAYERS; ++Layer) {
+			const float Gap = FMath::Max(LayerMinZ[Layer] - NewMaxZ, NewMinZ - LayerMaxZ[Layer]);
+			if (Gap < ClosestGap) {
+				ClosestGap = Gap;
+				FreeLayer = Layer;
+			}
+		}
+		NewMinZ = FMath::Min(NewMinZ, LayerMinZ[FreeLayer]);
+		NewMaxZ = FMath::Max(NewMaxZ, LayerMaxZ[FreeLayer]);
+	}
+
+	LayerMinZ[FreeLayer] = NewMinZ;
+	LayerMaxZ[FreeLayer] = NewMaxZ;
+}
+
+void FOcclusionHeightGrid::AddOccluders(const UOccluderSegmentData * Occluders) {
+	if (!Occluders) {
+		return;
+	}
+
+	for (int32 Loop = 0; Loop < Occluders->GetNumLoops(); ++Loop) {
+		const int32 Start = Occluders->GetLoopStart(Loop);
+		const int32 Num = Occluders->GetLoopNum(Loop);
+		const float MinZ = Occluders->LoopMinZ[Loop];
+		const float MaxZ = Occluders->LoopMaxZ[Loop];
+		TSet<int32> Cells;
+
+		// Cells whose center is inside the (convex, counter clockwise) loop
+		const FBox2D& Bounds = Occluders->LoopBounds[Loop];
+		const int32 MinX = FMath::Max(0, FMath::FloorToInt((Bounds.Min.X - Origin.X) / CellSize));
+		const int32 MaxX = FMath::Min(CellsX - 1, FMath::FloorToInt((Bounds.Max.X - Origin.X) / CellSize));
+		const int32 MinY = FMath::Max(0, FMath::FloorToInt((Bounds.Min.Y - Origin.Y) / CellSize));
+		const int32 MaxY = FMath::Min(CellsY - 1, FMath::FloorToInt((Bounds.Max.Y - Origin.Y) / CellSize));
+		for (int32 CellY = MinY; CellY <= MaxY; ++CellY) {
+			for (int32 CellX = MinX; CellX <= MaxX; ++CellX) {
+				const FVector2D Center = Origin + FVector2D((CellX + 0.5f) * CellSize, (CellY + 0.5f) * CellSize);
+				bool Inside = Num > 2;
+				for (int32 Index = 0; Index < Num && Inside; ++Index) {
+					const FVector2D A = Occluders->Points[Start + Index];
+					const FVector2D B = Occluders->Points[Start + (Index + 1) % Num];
+					Inside = FVector2D::CrossProduct(B - A, Center - A) >= 0;
+				}
+				if (Inside) {
+					Cells.Add(CellY * CellsX + CellX);
+				}
+			}
+		}
+
+		// Thin walls may not cover any cell center, so the cells under the edges are added too
+		for (int32 Index = 0; Index < Num; ++Index) {
+			const FVector2D A = Occluders->Points[Start + Index];
+			const FVector2D B = Occluders->Points[Start + (Index + 1) % Num];
+			const int32 Steps = FMath::Max(1, FMath::CeilToInt(FVector2D::Distance(A, B) / (CellSize * 0.5f)));
+			for (int32 Step = 0; Step <= Steps; ++Step) {
+				const int32 Cell = GetCellIndex(FMath::Lerp(A, B, (float)Step / Steps));
+				if (Cell != INDEX_NONE) {
+					Cells.Add(Cell);
+				}
+			}
+		}
+
+		for (auto It = Cells.CreateConstIterator(); It; ++It) {
+			AddBlockingInterval(*It, MinZ, MaxZ);
+		}
+	}
+}
+
+bool FOcclusionHeightGrid::CellBlocksAtHeight(const int32 Cell, const float Z) const {
+	const int32 First = Cell * MAX_LAYERS;
+	for (int32 Layer = First; Layer < First + MAX_LAYERS; ++Layer) {
+		if (LayerMinZ[Layer] <= Z && Z <= LayerMaxZ[Layer]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FOcclusionHeightGrid::IsBlockedAt(const FVector Point) const {
+	const int32 Cell = GetCellIndex(FVector2D(Point.X, Point.Y));
+	return Cell != INDEX_NONE && CellBlocksAtHeight(Cell, Point.Z);
+}
+
+float FOcclusionHeightGrid::GetBlockingHeight(const FVector2D Point) const {
+	float Height = -BIG_NUMBER;
+	const int32 Cell = GetCellIndex(Point);
+	if (Cell != INDEX_NONE) {
+		for (int32 Layer = Cell * MAX_LAYERS; Layer < (Cell + 1) * MAX_LAYERS; ++Layer) {
+			if (LayerMinZ[Layer] <= LayerMaxZ[Layer]) {
+				Height = FMath::Max(Height, LayerMaxZ[Layer]);
+			}
+		}
+	}
+	return Height;
+}
+
+bool FOcclusionHeightGrid::IsLineOfSightBlocked(const FVector From, const FVector To) const {
+	const FVector2D From2D = FVector2D(From.X, From.Y);
+	const FVector2D To2D = FVector2D(To.X, To.Y);
+	const int32 FromCell = GetCellIndex(From2D);
+	const int32 ToCell = GetCellIndex(To2D);
+
+	// Half a cell per step so no cell under the segment is skipped
+	const int32 Steps = FMath::CeilToInt(FVector2D::Distance(From2D, To2D) / (CellSize * 0.5f));
+	int32 PreviousCell = INDEX_NONE;
+	for (int32 Step = 1; Step < Steps; ++Step) {
+		const float Alpha = (float)Step / Steps;
+		const int32 Cell = GetCellIndex(FMath::Lerp(From2D, To2D, Alpha));
+		if (Cell == INDEX_NONE || Cell == PreviousCell || Cell == FromCell || Cell == ToCell) {
+			continue;
+		}
+		PreviousCell = Cell;
+
+		if (CellBlocksAtHeight(Cell, FMath::Lerp(From.Z, To.Z, Alpha))) {
+			return true;
+		}
+	}
+	return false;
+}
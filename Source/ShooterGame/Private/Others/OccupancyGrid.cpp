@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Others/OccluderSegmentData.h"
+#include "Public/Others/OccupancyGrid.h"
+
+FOccupancyGrid::FOccupancyGrid(const FBox2D& Bounds, const float Height, const float CellSize)
+	: Origin(Bounds.Min)
+	, CellSize(FMath::Max(CellSize, 1.0f))
+	, Height(Height)
+{
+	const FVector2D Size = Bounds.GetSize();
+	CellsX = FMath::Max(1, FMath::CeilToInt(Size.X / this->CellSize));
+	CellsY = FMath::Max(1, FMath::CeilToInt(Size.Y / this->CellSize));
+	Cells.Init(CELL_EMPTY, CellsX * CellsY);
+}
+
+float FOccupancyGrid::GetHeight() const {
+	return Height;
+}
+
+void FOccupancyGrid::MarkCell(const int32 CellX, const int32 CellY, const uint8 State) {
+	if (CellX < 0 || CellX >= CellsX || CellY < 0 || CellY >= CellsY) {
+		return;
+	}
+	uint8& Cell = Cells[CellY * CellsX + CellX];
+	Cell = FMath::Max(Cell, State);
+}
+
+static bool PointInsideConvexLoop(const UOccluderSegmentData * Occluders, const int32 Start, const int32 Num, const FVector2D Point) {
+	if (Num < 3) {
+		return false;
+	}
+	for (int32 Index = 0; Index < Num; ++Index) {
+		const FVector2D A = Occluders->Points[Start + Index];
+		const FVector2D B = Occluders->Points[Start + (Index + 1) % Num];
+		if (FVector2D::CrossProduct(B - A, Point - A) < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void FOccupancyGrid::AddOccluders(const UOccluderSegmentData * Occluders) {
+	if (!Occluders) {
+		return;
+	}
+
+	for (int32 Loop = 0; Loop < Occluders->GetNumLoops(); ++Loop) {
+		if (!Occluders->LoopBlocksAtHeight(Loop, Height)) {
+			continue;
+		}
+		const int32 Start = Occluders->GetLoopStart(Loop);
+		const int32 Num = Occluders->GetLoopNum(Loop);
+
+		// Convex loop: the cell is covered if its four corners are inside
+		const FBox2D& Bounds = Occluders->LoopBounds[Loop];
+		const int32 MinX = FMath::FloorToInt((Bounds.Min.X - Origin.X) / CellSize);
+		const int32 MaxX = FMath::FloorToInt((Bounds.Max.X - Origin.X) / CellSize);
+		const int32 MinY = FMath::FloorToInt((Bounds.Min.Y - Origin.Y) / CellSize);
+		const int32 MaxY = FMath::FloorToInt((Bounds.Max.Y - Origin.Y) / CellSize);
+		for (int32 CellY = MinY; CellY <= MaxY; ++CellY) {
+			for (int32 CellX = MinX; CellX <= MaxX; ++CellX) {
+				const FVector2D Corner = Origin + FVector2D(CellX * CellSize, CellY * CellSize);
+				int32 CornersInside = 0;
+				CornersInside += PointInsideConvexLoop(Occluders, Start, Num, Corner) ? 1 : 0;
+				CornersInside += PointInsideConvexLoop(Occluders, Start, Num, Corner + FVector2D(CellSize, 0)) ? 1 : 0;
+				CornersInside += PointInsideConvexLoop(Occluders, Start, Num, Corner + FVector2D(0, CellSize)) ? 1 : 0;
+				CornersInside += PointInsideConvexLoop(Occluders, Start, Num, Corner + FVector2D(CellSize, CellSize)) ? 1 : 0;
+
+				if (CornersInside == 4) {
+					MarkCell(CellX, CellY, CELL_FULL);
+				}
+				else if (CornersInside > 0 || PointInsideConvexLoop(Occluders, Start, Num, Corner + FVector2D(CellSize, CellSize) * 0.5f)) {
+					MarkCell(CellX, CellY, CELL_PARTIAL);
+				}
+			}
+		}
+
+		// Cells under the edges are at least partial (thin walls, small pillars)
+		for (int32 Index = 0; Index < Num; ++Index) {
+			const FVector2D A = Occluders->Points[Start + Index];
+			const FVector2D B = Occluders->Points[Start + (Index + 1) % Num];
+			const int32 Steps = FMath::Max(1, FMath::CeilToInt(FVector2D::Distance(A, B) / (CellSize * 0.5f)));
+			for (int32 Step = 0; Step <= Steps; ++Step) {
+				const FVector2D Point = FMath::Lerp(A, B, (float)Step / Steps);
+				MarkCell(FMath::FloorToInt((Point.X - Origin.X) / CellSize), FMath::FloorToInt((Point.Y - Origin.Y) / CellSize), CELL_PARTIAL);
+			}
+		}
+	}
+}
+
+uint8 FOccupancyGrid::GetCellState(const FVector2D Point) const {
+	const int32 CellX = FMath::FloorToInt((Point.X - Origin.X) / CellSize);
+	const int32 CellY = FMath::FloorToInt((Point.Y - Origin.Y) / CellSize);
+	if (CellX < 0 || CellX >= CellsX || CellY < 0 || CellY >= CellsY) {
+		return CELL_EMPTY;
+	}
+	return Cells[CellY * CellsX + CellX];
+}
+
+ELineOfSight FOccupancyGrid::GetLineOfSight(const FVector2D From, const FVector2D To) const {
+	// Grid space
+	const FVector2D Start = (From - Origin) / CellSize;
+	const FVector2D End = (To - Origin) / CellSize;
+
+	int32 CellX = FMath::FloorToInt(Start.X);
+	int32 CellY = FMath::FloorToInt(Start.Y);
+	const int32 EndX = FMath::FloorToInt(End.X);
+	const int32 EndY = FMath::FloorToInt(End.Y);
+	if (CellX < 0 || CellX >= CellsX || CellY < 0 || CellY >= CellsY || EndX < 0 || EndX >= CellsX || EndY < 0 || EndY >= CellsY) {
+		return ELineOfSight::Uncertain;
+	}
+
+	const FVector2D Direction = End - Start;
+	const int32 StepX = (Direction.X >= 0) ? 1 : -1;
+	const int32 StepY = (Direction.Y >= 0) ? 1 : -1;
+	// Distance (in segment units) to cross one cell, and to the first cell border
+	const float DeltaX = (Direction.X != 0) ? FMath::Abs(1.0f / Direction.X) : BIG_NUMBER;
+	const float DeltaY = (Direction.Y != 0) ? FMath::Abs(1.0f / Direction.Y) : BIG_NUMBER;
+	float NextX = (Direction.X != 0) ? ((StepX > 0) ? (CellX + 1 - Start.X) : (Start.X - CellX)) * DeltaX : BIG_NUMBER;
+	float NextY = (Direction.Y != 0) ? ((StepY > 0) ? (CellY + 1 - Start.Y) : (Start.Y - CellY)) * DeltaY : BIG_NUMBER;
+
+	bool CrossesPartialCells = false;
+	const int32 MaxSteps = FMath::Abs(EndX - CellX) + FMath::Abs(EndY - CellY);
+	for (int32 Step = 0; Step < MaxSteps; ++Step) {
+		if (NextX < NextY) {
+			CellX += StepX;
+			NextX += DeltaX;
+		}
+		else {
+			CellY += StepY;
+			NextY += DeltaY;
+		}
+
+		if (CellX == EndX && CellY == EndY) {
+			break;
+		}
+
+		const uint8 State = Cells[CellY * CellsX + CellX];
+		if (State == CELL_FULL) {
+			return ELineOfSight::Blocked;
+		}
+		CrossesPartialCells |= (State == CELL_PARTIAL);
+	}
+
+	return CrossesPartialCells ? ELineOfSight::Uncertain : ELineOfSight::Clear;
+}
+
+void FOccupancyGrid::GetLineOfSight(const FVector2D From, const TArray<FVector2D> &To, TArray<ELineOfSight> &OutLineOfSight) const {
+	OutLineOfSight.SetNumUninitialized(To.Num());
+	for (int32 Index = 0; Index < To.Num(); ++Index) {
+		OutLineOfSight[Index] = GetLineOfSight(From, To[Index]);
+	}
+}
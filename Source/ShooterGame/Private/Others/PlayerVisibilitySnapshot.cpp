@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Others/HelperMethods.h"
+#include "Public/Others/PlayerVisibilitySnapshot.h"
+
+FPlayerVisibilitySnapshot::FPlayerVisibilitySnapshot(const FVector Location, const FVector ForwardVector, TArray<Triangle>&& Triangles)
+	: Location(Location)
+	, ForwardVector(ForwardVector)
+	, Triangles(MoveTemp(Triangles))
+	, Fan(FVisibilityFan::Create(this->Triangles))
+	, Frame(GFrameCounter)
+{
+}
+
+//----------------------------------------------------------------------//
+// PlayerVisibilitySnapshots
+//----------------------------------------------------------------------//
+
+struct FPlayerVisibilityEntry {
+	TWeakObjectPtr<UWorld> World;
+	TWeakObjectPtr<const APawn> Player;
+	FPlayerVisibilitySnapshotPtr Snapshot;
+	uint64 LastRequestFrame = 0;
+	bool AsyncInFlight = false;
+};
+
+static TArray<FPlayerVisibilityEntry> PlayerVisibilityEntries;
+
+static FPlayerVisibilityEntry& FindOrAddEntry(UWorld * World, const APawn * Player) {
+	// Forget players and worlds that are gone (PIE sessions, respawns)
+	PlayerVisibilityEntries.RemoveAll([](const FPlayerVisibilityEntry& Entry) {
+		return !Entry.World.IsValid() || !Entry.Player.IsValid();
+	});
+
+	for (auto It = PlayerVisibilityEntries.CreateIterator(); It; ++It) {
+		if (It->World.Get() == World && It->Player.Get() == Player) {
+			return *It;
+		}
+	}
+
+	FPlayerVisibilityEntry& Entry = PlayerVisibilityEntries[PlayerVisibilityEntries.AddDefaulted()];
+	Entry.World = World;
+	Entry.Player = Player;
+	return Entry;
+}
+
+void PlayerVisibilitySnapshots::Request(UWorld * World, APawn * Player, const bool Async) {
+	if (!World || !Player) {
+		return;
+	}
+
+	FPlayerVisibilityEntry& Entry = FindOrAddEntry(World, Player);
+	if (Entry.LastRequestFrame == GFrameCounter) {
+		return;
+	}
+	Entry.LastRequestFrame = GFrameCounter;
+
+	const FVector Location = Player->GetActorLocation();
+	const FVector ForwardVector = Player->GetActorForwardVector();
+
+	if (Async) {
+		// One batch in flight per player, its result is published next frame
+		if (Entry.AsyncInFlight) {
+			return;
+		}
+		Entry.AsyncInFlight = true;
+		HelperMethods::CalculateVisibilityAsync(World, Location, ForwardVector, FVisibilityCalculatedDelegate::CreateStatic(&PlayerVisibilitySnapshots::OnAsyncCalculated, TWeakObjectPtr<APawn>(Player), Location, ForwardVector));
+	}
+	else {
+		Publish(World, Player, MakeShareable(new FPlayerVisibilitySnapshot(Location, ForwardVector, HelperMethods::CalculateVisibility(World, Location, ForwardVector))));
+	}
+}
+
+void PlayerVisibilitySnapshots::OnAsyncCalculated(TArray<Triangle>& VisibleTriangles, TWeakObjectPtr<APawn> Player, FVector Location, FVector ForwardVector) {
+	if (!Player.IsValid()) {
+		return;
+	}
+
+	UWorld * World = Player->GetWorld();
+	FPlayerVisibilityEntry& Entry = FindOrAddEntry(World, Player.Get());
+	Entry.AsyncInFlight = false;
+
+	// Everybody lost the player while the traces were in flight
+	if (Entry.LastRequestFrame + 1 < GFrameCounter) {
+		return;
+	}
+	Publish(World, Player.Get(), MakeShareable(new FPlayerVisibilitySnapshot(Location, ForwardVector, MoveTemp(VisibleTriangles))));
+}
+
+void PlayerVisibilitySnapshots::Release(UWorld * World, const APawn * Player) {
+	bool Released = false;
+	for (auto It = PlayerVisibilityEntries.CreateIterator(); It; ++It) {
+		if (It->World.Get() != World || (Player && It->Player.Get() != Player)) {
+			continue;
+		}
+		if (It->Snapshot.IsValid() && It->LastRequestFrame + 1 < GFrameCounter) {
+			It->Snapshot.Reset();
+			Released = true;
+
+			AMyRecastNavMesh* NavMesh = HelperMethods::GetNavMesh(World);
+			if (NavMesh) {
+				NavMesh->RemoveObserverCoverage(It->Player.Get());
+			}
+		}
+	}
+
+	if (Released) {
+		PublishThreatField(World);
+	}
+}
+
+FPlayerVisibilitySnapshotPtr PlayerVisibilitySnapshots::Get(UWorld * World, const APawn * Player) {
+	FPlayerVisibilitySnapshotPtr Latest;
+	for (auto It = PlayerVisibilityEntries.CreateConstIterator(); It; ++It) {
+		if (It->World.Get() != World || !It->Snapshot.IsValid()) {
+			continue;
+		}
+		if (Player) {
+			if (It->Player.Get() == Player) {
+				return It->Snapshot;
+			}
+		}
+		else if (!Latest.IsValid() || It->Snapshot->Frame > Latest->Frame) {
+			Latest = It->Snapshot;
+		}
+	}
+	return Latest;
+}
+
+void PlayerVisibilitySnapshots::Publish(UWorld * World, const APawn * Player, FPlayerVisibilitySnapshotPtr Snapshot) {
+	FPlayerVisibilityEntry& Entry = FindOrAddEntry(World, Player);
+	Entry.Snapshot = Snapshot;
+
+	// Update Navigation Mesh
+	PublishThreatField(World);
+
+	// Update team coverage
+	AMyRecastNavMesh* NavMesh = HelperMethods::GetNavMesh(World);
+	if (NavMesh) {
+		if (Snapshot.IsValid()) {
+			NavMesh->UpdateObserverCoverage(Player, *Snapshot->Fan);
+		}
+		else {
+			NavMesh->RemoveObserverCoverage(Player);
+		}
+	}
+}
+
+void PlayerVisibilitySnapshots::PublishThreatField(UWorld * World) {
+	AMyRecastNavMesh* NavMesh = HelperMethods::GetNavMesh(World);
+	if (NavMesh) {
+		TSharedPtr<const FVisibilityFan, ESPMode::ThreadSafe> PlayerVisibility;
+		const FPlayerVisibilitySnapshotPtr Latest = Get(World);
+		if (Latest.IsValid()) {
+			PlayerVisibility = Latest->Fan;
+		}
+		NavMesh->PublishPlayerVisibility(PlayerVisibility);
+	}
+}
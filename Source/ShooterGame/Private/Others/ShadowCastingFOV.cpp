@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Others/ShadowCastingFOV.h"
+
+// Direction of the rows of each quadrant: north, east, south, west
+static const FVector2D QUADRANT_AXIS[4] = { FVector2D(0, -1), FVector2D(1, 0), FVector2D(0, 1), FVector2D(-1, 0) };
+
+FShadowCastingFOV::FShadowCastingFOV()
+	: CellsX(0)
+	, CellsY(0)
+{
+}
+
+void FShadowCastingFOV::Initialize(const TBitArray<> &Opaque, const int32 CellsX, const int32 CellsY) {
+	check(Opaque.Num() == CellsX * CellsY);
+	this->Opaque = Opaque;
+	this->CellsX = CellsX;
+	this->CellsY = CellsY;
+}
+
+bool FShadowCastingFOV::IsOpaque(const int32 X, const int32 Y) const {
+	if (X < 0 || X >= CellsX || Y < 0 || Y >= CellsY) {
+		return true;
+	}
+	return Opaque[Y * CellsX + X];
+}
+
+void FShadowCastingFOV::GetVisibleCells(const int32 OriginX, const int32 OriginY, const FVector2D ForwardVector, const float ViewAngle, const float Range, TArray<int32> &OutVisibleCells) const {
+	OutVisibleCells.Reset();
+	if (OriginX < 0 || OriginX >= CellsX || OriginY < 0 || OriginY >= CellsY) {
+		return;
+	}
+	OutVisibleCells.Add(OriginY * CellsX + OriginX);
+
+	FScan Scan;
+	Scan.OriginX = OriginX;
+	Scan.OriginY = OriginY;
+	Scan.Forward = ForwardVector.GetSafeNormal();
+	Scan.CosViewAngle = (ViewAngle >= 180 || Scan.Forward.IsZero()) ? -1.0f : FMath::Cos(FMath::DegreesToRadians(ViewAngle));
+	// No need to go further than the grid diagonal, the farthest cell from any origin
+	Scan.Range = FMath::Min(Range, FMath::Sqrt((float)(CellsX * CellsX + CellsY * CellsY)));
+	Scan.VisibleCells = &OutVisibleCells;
+
+	for (int32 Quadrant = 0; Quadrant < 4; ++Quadrant) {
+		// Each quadrant spans 45 degrees at each side of its axis
+		if (Scan.CosViewAngle > -1.0f) {
+			const float AxisAngle = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(FVector2D::DotProduct(Scan.Forward, QUADRANT_AXIS[Quadrant]), -1.0f, 1.0f)));
+			if (AxisAngle > ViewAngle + 45) {
+				continue;
+			}
+		}
+		Scan.Quadrant = Quadrant;
+		ScanRow(Scan, 1, -1.0f, 1.0f);
+	}
+
+	// Cells on the diagonals belong to two quadrants
+	OutVisibleCells.Sort();
+	int32 Unique = 0;
+	for (int32 Index = 0; Index < OutVisibleCells.Num(); ++Index) {
+		if (Index == 0 || OutVisibleCells[Index] != OutVisibleCells[Unique - 1]) {
+			OutVisibleCells[Unique++] = OutVisibleCells[Index];
+		}
+	}
+	OutVisibleCells.SetNum(Unique, false);
+}
+
+void FShadowCastingFOV::ScanRow(const FScan &Scan, const int32 Depth, float StartSlope, const float EndSlope) const {
+	if (Depth > Scan.Range || StartSlope >= EndSlope) {
+		return;
+	}
+
+	// Columns whose center is inside the slopes, ties rounded towards the inside
+	const int32 MinColumn = FMath::FloorToInt(Depth * StartSlope + 0.5f);
+	const int32 MaxColumn = FMath::CeilToInt(Depth * EndSlope - 0.5f);
+
+	bool HasPrevious = false;
+	bool PreviousOpaque = false;
+	for (int32 Column = MinColumn; Column <= MaxColumn; ++Column) {
+		int32 X, Y;
+		GetCell(Scan, Depth, Column, X, Y);
+		const bool CellOpaque = IsOpaque(X, Y);
+
+		// Floor cells are only visible if their center is inside the slopes (symmetry), walls are always visible
+		if (CellOpaque || (Column >= Depth * StartSlope && Column <= Depth * EndSlope)) {
+			RevealCell(Scan, X, Y);
+		}
+
+		// Slope of the left edge of the cell
+		const float ColumnSlope = (2.0f * Column - 1.0f) / (2.0f * Depth);
+		if (HasPrevious && PreviousOpaque && !CellOpaque) {
+			StartSlope = ColumnSlope;
+		}
+		if (HasPrevious && !PreviousOpaque && CellOpaque) {
+			ScanRow(Scan, Depth + 1, StartSlope, ColumnSlope);
+		}
+		HasPrevious = true;
+		PreviousOpaque = CellOpaque;
+	}
+	if (HasPrevious && !PreviousOpaque) {
+		ScanRow(Scan, Depth + 1, StartSlope, EndSlope);
+	}
+}
+
+void FShadowCastingFOV::RevealCell(const FScan &Scan, const int32 X, const int32 Y) const {
+	if (X < 0 || X >= CellsX || Y < 0 || Y >= CellsY) {
+		return;
+	}
+	const FVector2D ToCell = FVector2D(X - Scan.OriginX, Y - Scan.OriginY);
+	const float DistanceSquared = ToCell.SizeSquared();
+	if (DistanceSquared > Scan.Range * Scan.Range) {
+		return;
+	}
+	if (Scan.CosViewAngle > -1.0f && FVector2D::DotProduct(ToCell, Scan.Forward) < Scan.CosViewAngle * FMath::Sqrt(DistanceSquared)) {
+		return;
+	}
+	Scan.VisibleCells->Add(Y * CellsX + X);
+}
+
+void FShadowCastingFOV::GetCell(const FScan &Scan, const int32 Depth, const int32 Column, int32 &OutX, int32 &OutY) const {
+	// Rows run along the axis of the quadrant, columns across it
+	switch (Scan.Quadrant) {
+	case 0:
+		OutX = Scan.OriginX + Column;
+		OutY = Scan.OriginY - Depth;
+		break;
+	case 1:
+		OutX = Scan.OriginX + Depth;
+		OutY = Scan.OriginY + Column;
+		break;
+	case 2:
+		OutX = Scan.OriginX + Column;
+		OutY = Scan.OriginY + Depth;
+		break;
+	default:
+		OutX = Scan.OriginX - Depth;
+		OutY = Scan.OriginY + Column;
+		break;
+	}
+}
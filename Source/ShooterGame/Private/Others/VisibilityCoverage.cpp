@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Others/VisibilityCoverage.h"
+
+FVisibilityCoverageGrid::FVisibilityCoverageGrid(const FBox2D& Bounds, const float CellSize)
+	: Origin(Bounds.Min)
+	, CellSize(FMath::Max(CellSize, 1.0f))
+{
+	const FVector2D Size = Bounds.GetSize();
+	CellsX = FMath::Max(1, FMath::CeilToInt(Size.X / this->CellSize));
+	CellsY = FMath::Max(1, FMath::CeilToInt(Size.Y / this->CellSize));
+	Counts.AddZeroed(CellsX * CellsY);
+}
+
+int32 FVisibilityCoverageGrid::GetCellIndex(const FVector2D Point) const {
+	const int32 CellX = FMath::FloorToInt((Point.X - Origin.X) / CellSize);
+	const int32 CellY = FMath::FloorToInt((Point.Y - Origin.Y) / CellSize);
+	if (CellX < 0 || CellX >= CellsX || CellY < 0 || CellY >= CellsY) {
+		return INDEX_NONE;
+	}
+	return CellY * CellsX + CellX;
+}
+
+FVector2D FVisibilityCoverageGrid::GetCellCenter(const int32 CellX, const int32 CellY) const {
+	return Origin + FVector2D((CellX + 0.5f) * CellSize, (CellY + 0.5f) * CellSize);
+}
+
+void FVisibilityCoverageGrid::Rasterize(const FVisibilityFan& Fan, TArray<int32>& OutCells) const {
+	OutCells.Reset();
+	if (Fan.IsEmpty()) {
+		return;
+	}
+
+	// Only the cells under the fan bounds, all their centers tested in one batch
+	const FBox2D& FanBounds = Fan.GetBounds();
+	const int32 MinX = FMath::Clamp(FMath::FloorToInt((FanBounds.Min.X - Origin.X) / CellSize), 0, CellsX - 1);
+	const int32 MaxX = FMath::Clamp(FMath::FloorToInt((FanBounds.Max.X - Origin.X) / CellSize), 0, CellsX - 1);
+	const int32 MinY = FMath::Clamp(FMath::FloorToInt((FanBounds.Min.Y - Origin.Y) / CellSize), 0, CellsY - 1);
+	const int32 MaxY = FMath::Clamp(FMath::FloorToInt((FanBounds.Max.Y - Origin.Y) / CellSize), 0, CellsY - 1);
+
+	TArray<FVector2D> Centers;
+	TArray<int32> Indexes;
+	Centers.Reserve((MaxX - MinX + 1) * (MaxY - MinY + 1));
+	Indexes.Reserve(Centers.Max());
+	for (int32 CellY = MinY; CellY <= MaxY; ++CellY) {
+		for (int32 CellX = MinX; CellX <= MaxX; ++CellX) {
+			Centers.Add(GetCellCenter(CellX, CellY));
+			Indexes.Add(CellY * CellsX + CellX);
+		}
+	}
+
+	TArray<bool> Inside;
+	Fan.ArePointsInside(Centers, Inside);
+	for (int32 Index = 0; Index < Inside.Num(); ++Index) {
+		if (Inside[Index]) {
+			OutCells.Add(Indexes[Index]);
+		}
+	}
+}
+
+void FVisibilityCoverageGrid::AddCell(const int32 Cell, const int32 Delta) {
+	Counts[Cell] = (uint8)FMath::Clamp((int32)Counts[Cell] + Delta, 0, 255);
+}
+
+void FVisibilityCoverageGrid::AddCells(const TArray<int32>& Cells, const int32 Delta) {
+	for (auto It = Cells.CreateConstIterator(); It; ++It) {
+		AddCell(*It, Delta);
+	}
+}
+
+void FVisibilityCoverageGrid::UpdateObserver(const AActor * Observer, const FVisibilityFan& Fan) {
+	if (!Observer) {
+		return;
+	}
+	RemoveStaleObservers();
+
+	TArray<int32> NewCells;
+	Rasterize(Fan, NewCells);
+
+	TArray<int32>* OldCells = ObserverCells.Find(Observer);
+	if (OldCells) {
+		// Both lists are sorted (rasterized row by row), only the difference is applied
+		int32 Old = 0, New = 0;
+		while (Old < OldCells->Num() || New < NewCells.Num()) {
+			if (New >= NewCells.Num() || (Old < OldCells->Num() && (*OldCells)[Old] < NewCells[New])) {
+				AddCell((*OldCells)[Old++], -1);
+			}
+			else if (Old >= OldCells->Num() || NewCells[New] < (*OldCells)[Old]) {
+				AddCell(NewCells[New++], 1);
+			}
+			else {
+				++Old;
+				++New;
+			}
+		}
+		*OldCells = MoveTemp(NewCells);
+	}
+	else {
+		AddCells(NewCells, 1);
+		ObserverCells.Add(Observer, MoveTemp(NewCells));
+	}
+}
+
+void FVisibilityCoverageGrid::RemoveObserver(const AActor * Observer) {
+	TArray<int32> Cells;
+	if (ObserverCells.RemoveAndCopyValue(Observer, Cells)) {
+		AddCells(Cells, -1);
+	}
+}
+
+void FVisibilityCoverageGrid::RemoveStaleObservers() {
+	for (auto It = ObserverCells.CreateIterator(); It; ++It) {
+		if (!It.Key().IsValid()) {
+			AddCells(It.Value(), -1);
+			It.RemoveCurrent();
+		}
+	}
+}
+
+int32 FVisibilityCoverageGrid::GetNumObservers() const {
+	return ObserverCells.Num();
+}
+
+int32 FVisibilityCoverageGrid::GetCoverageCount(const FVector2D Point) const {
+	const int32 Index = GetCellIndex(Point);
+	return (Index == INDEX_NONE) ? 0 : Counts[Index];
+}
+
+bool FVisibilityCoverageGrid::IsPointCovered(const FVector2D Point) const {
+	return GetCoverageCount(Point) > 0;
+}
+
+float FVisibilityCoverageGrid::GetSegmentCoverage(const FVector2D From, const FVector2D To) const {
+	const float Length = FVector2D::Distance(From, To);
+	const int32 Steps = FMath::Max(1, FMath::CeilToInt(Length / (CellSize * 0.5f)));
+
+	int32 CoveredSamples = 0;
+	for (int32 Step = 0; Step <= Steps; ++Step) {
+		if (IsPointCovered(FMath::Lerp(From, To, (float)Step / Steps))) {
+			++CoveredSamples;
+		}
+	}
+	return (float)CoveredSamples / (Steps + 1);
+}
+
+bool FVisibilityCoverageGrid::IsSegmentCovered(const FVector2D From, const FVector2D To) const {
+	const float Length = FVector2D::Distance(From, To);
+	const int32 Steps = FMath::Max(1, FMath::CeilToInt(Length / (CellSize * 0.5f)));
+
+	for (int32 Step = 0; Step <= Steps; ++Step) {
+		if (IsPointCovered(FMath::Lerp(From, To, (float)Step / Steps))) {
+			return true;
+		}
+	}
+	return false;
+}
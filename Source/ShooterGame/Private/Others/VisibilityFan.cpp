@@ -0,0 +1,360 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ShooterGame.h"
+#include "Public/Navigation/MyRecastNavMesh.h"
+#include "Public/Others/VisibilityFan.h"
+
+FVisibilityFan::FVisibilityFan()
+	: Eyes(0, 0)
+	, Bounds(ForceInit)
+	, StartDirection(1, 0)
+	, AngleSign(1)
+	, MaxAngle(0)
+	, HasAngularIndex(false)
+{
+}
+
+FVisibilityFan::FVisibilityFan(const TArray<Triangle>& Triangles)
+	: FVisibilityFan()
+{
+	Build(Triangles);
+}
+
+TSharedRef<const FVisibilityFan, ESPMode::ThreadSafe> FVisibilityFan::Create(const TArray<Triangle>& Triangles) {
+	return MakeShareable(new FVisibilityFan(Triangles));
+}
+
+void FVisibilityFan::Build(const TArray<Triangle>& Triangles) {
+	Bounds = FBox2D(ForceInit);
+	for (int32 Edge = 0; Edge < 3; ++Edge) {
+		EdgeA[Edge].Reset(Triangles.Num());
+		EdgeB[Edge].Reset(Triangles.Num());
+		EdgeC[Edge].Reset(Triangles.Num());
+	}
+	SectorStart.Reset(Triangles.Num());
+	SectorEnd.Reset(Triangles.Num());
+	HasAngularIndex = false;
+
+	// Sector limits of each triangle: previous vertex (V3) and current vertex (V1) seen from the eyes
+	TArray<FVector2D> FirstBoundary;
+	TArray<FVector2D> LastBoundary;
+
+	if (Triangles.Num() == 0) {
+		return;
+	}
+
+	Eyes = FVector2D(Triangles[0].V2.X, Triangles[0].V2.Y);
+
+	for (auto It = Triangles.CreateConstIterator(); It; ++It) {
+		const Triangle& Tri = *It;
+		const FVector2D Vertexs[3] = { FVector2D(Tri.V1.X, Tri.V1.Y), FVector2D(Tri.V2.X, Tri.V2.Y), FVector2D(Tri.V3.X, Tri.V3.Y) };
+
+		// Sectors with no area (i.e. vertex and its projection) can't contain anything
+		const float DoubleArea = FVector2D::CrossProduct(Vertexs[1] - Vertexs[0], Vertexs[2] - Vertexs[0]);
+		if (FMath::Abs(DoubleArea) < KINDA_SMALL_NUMBER) {
+			continue;
+		}
+		const float Orientation = FMath::Sign(DoubleArea);
+
+		// Edges (V1,V2), (V2,V3), (V3,V1)
+		for (int32 Edge = 0; Edge < 3; ++Edge) {
+			const FVector2D Start = Vertexs[Edge];
+			const FVector2D End = Vertexs[(Edge + 1) % 3];
+			const float A = -(End.Y - Start.Y) * Orientation;
+			const float B = (End.X - Start.X) * Orientation;
+			EdgeA[Edge].Add(A);
+			EdgeB[Edge].Add(B);
+			EdgeC[Edge].Add(-(A * Start.X + B * Start.Y));
+		}
+
+		FirstBoundary.Add(Vertexs[2] - Eyes);
+		LastBoundary.Add(Vertexs[0] - Eyes);
+
+		Bounds += Vertexs[0];
+		Bounds += Vertexs[1];
+		Bounds += Vertexs[2];
+	}
+
+	BuildAngularIndex(FirstBoundary, LastBoundary);
+}
+
+void FVisibilityFan::BuildAngularIndex(const TArray<FVector2D>& FirstBoundary, const TArray<FVector2D>& LastBoundary) {
+	const int32 NumTriangles = Num();
+	if (NumTriangles == 0) {
+		return;
+	}
+
+	StartDirection = FirstBoundary[0].GetSafeNormal();
+	AngleSign = 1;
+	const FVector2D LastDirection = LastBoundary[NumTriangles - 1];
+	if (FVector2D::CrossProduct(StartDirection, LastDirection) < 0) {
+		AngleSign = -1;
+	}
+
+	bool Sorted = true;
+	for (int32 Index = 0; Index < NumTriangles; ++Index) {
+		float Start = GetPseudoAngle(Eyes + FirstBoundary[Index]);
+		float End = GetPseudoAngle(Eyes + LastBoundary[Index]);
+		if (Start > End) {
+			Swap(Start, End);
+		}
+		// Sectors must be consecutive and the whole fan below 180 degrees (pseudo angle 2)
+		if (End >= 2.0f || (Index > 0 && Start < SectorEnd[Index - 1] - KINDA_SMALL_NUMBER)) {
+			Sorted = false;
+		}
+		SectorStart.Add(Start);
+		SectorEnd.Add(End);
+	}
+
+	HasAngularIndex = Sorted;
+	if (!HasAngularIndex) {
+		return;
+	}
+
+	MaxAngle = SectorEnd[NumTriangles - 1];
+	BinFirstSector.Init(INDEX_NONE, NUM_ANGULAR_BINS);
+	BinLastSector.Init(INDEX_NONE, NUM_ANGULAR_BINS);
+	const float BinSize = FMath::Max(MaxAngle, KINDA_SMALL_NUMBER) / NUM_ANGULAR_BINS;
+	for (int32 Index = 0; Index < NumTriangles; ++Index) {
+		const int32 FirstBin = FMath::Clamp(FMath::FloorToInt(SectorStart[Index] / BinSize), 0, NUM_ANGULAR_BINS - 1);
+		const int32 LastBin = FMath::Clamp(FMath::FloorToInt(SectorEnd[Index] / BinSize), 0, NUM_ANGULAR_BINS - 1);
+		for (int32 Bin = FirstBin; Bin <= LastBin; ++Bin) {
+			if (BinFirstSector[Bin] == INDEX_NONE) {
+				BinFirstSector[Bin] = Index;
+			}
+			BinLastSector[Bin] = Index;
+		}
+	}
+}
+
+bool FVisibilityFan::IsEmpty() const {
+	return Num() == 0;
+}
+
+int32 FVisibilityFan::Num() const {
+	return EdgeA[0].Num();
+}
+
+const FBox2D& FVisibilityFan::GetBounds() const {
+	return Bounds;
+}
+
+FVector2D FVisibilityFan::GetEyes() const {
+	return Eyes;
+}
+
+// "Diamond angle": monotonic with the real angle, in [0, 4), without trigonometry
+float FVisibilityFan::GetPseudoAngle(const FVector2D Point) const {
+	const FVector2D Direction = Point - Eyes;
+	const float X = FVector2D::DotProduct(StartDirection, Direction);
+	const float Y = FVector2D::CrossProduct(StartDirection, Direction) * AngleSign;
+
+	if (X == 0 && Y == 0) {
+		return 0;
+	}
+	if (Y >= 0) {
+		return (X >= 0) ? Y / (X + Y) : 1 - X / (-X + Y);
+	}
+	return (X < 0) ? 2 - Y / (-X - Y) : 3 + X / (X - Y);
+}
+
+float FVisibilityFan::GetEdgeValue(const int32 Edge, const int32 Index, const FVector2D Point) const {
+	return EdgeA[Edge][Index] * Point.X + EdgeB[Edge][Index] * Point.Y + EdgeC[Edge][Index];
+}
+
+bool FVisibilityFan::IsInsideTriangle(const int32 Index, const FVector2D Point) const {
+	return GetEdgeValue(0, Index, Point) >= 0 && GetEdgeValue(1, Index, Point) >= 0 && GetEdgeValue(2, Index, Point) >= 0;
+}
+
+bool FVisibilityFan::IsPointInside(const FVector2D Point) const {
+	if (IsEmpty() || !Bounds.IsInside(Point)) {
+		return false;
+	}
+
+	if (!HasAngularIndex) {
+		for (int32 Index = 0; Index < Num(); ++Index) {
+			if (IsInsideTriangle(Index, Point)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Angular lookup: the sector gives the two side edges, then only the far edge is left
+	const float Angle = GetPseudoAngle(Point);
+	if (Angle > MaxAngle) {
+		return false;
+	}
+	const int32 Bin = FMath::Min(FMath::FloorToInt(Angle / FMath::Max(MaxAngle, KINDA_SMALL_NUMBER) * NUM_ANGULAR_BINS), NUM_ANGULAR_BINS - 1);
+	if (BinFirstSector[Bin] == INDEX_NONE) {
+		return false;
+	}
+	for (int32 Index = BinFirstSector[Bin]; Index <= BinLastSector[Bin]; ++Index) {
+		if (Angle >= SectorStart[Index] && Angle <= SectorEnd[Index]) {
+			return GetEdgeValue(2, Index, Point) >= 0;
+		}
+	}
+	return false;
+}
+
+int32 FVisibilityFan::ArePointsInside(const FVector2D* Points, const int32 Count, bool* OutInside) const {
+	int32 NumInside = 0;
+	if (IsEmpty()) {
+		FMemory::Memzero(OutInside, Count * sizeof(bool));
+		return NumInside;
+	}
+
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister BoundsMinX = VectorLoadFloat1(&Bounds.Min.X);
+	const VectorRegister BoundsMinY = VectorLoadFloat1(&Bounds.Min.Y);
+	const VectorRegister BoundsMaxX = VectorLoadFloat1(&Bounds.Max.X);
+	const VectorRegister BoundsMaxY = VectorLoadFloat1(&Bounds.Max.Y);
+
+	for (int32 Base = 0; Base < Count; Base += 4) {
+		const int32 Lanes = FMath::Min(4, Count - Base);
+		const int32 LanesMask = (1 << Lanes) - 1;
+
+		// Unused lanes repeat the last valid point of the batch, LanesMask drops them
+		const FVector2D& P0 = Points[Base];
+		const FVector2D& P1 = Points[Base + FMath::Min(1, Lanes - 1)];
+		const FVector2D& P2 = Points[Base + FMath::Min(2, Lanes - 1)];
+		const FVector2D& P3 = Points[Base + FMath::Min(3, Lanes - 1)];
+		const VectorRegister X = MakeVectorRegister(P0.X, P1.X, P2.X, P3.X);
+		const VectorRegister Y = MakeVectorRegister(P0.Y, P1.Y, P2.Y, P3.Y);
+
+		int32 InsideMask = 0;
+		const VectorRegister InBounds = VectorBitwiseAnd(
+			VectorBitwiseAnd(VectorCompareGE(X, BoundsMinX), VectorCompareGE(BoundsMaxX, X)),
+			VectorBitwiseAnd(VectorCompareGE(Y, BoundsMinY), VectorCompareGE(BoundsMaxY, Y)));
+
+		if (VectorMaskBits(InBounds) & LanesMask) {
+			VectorRegister Inside = VectorZero();
+			for (int32 Index = 0; Index < Num(); ++Index) {
+				const VectorRegister E0 = VectorMultiplyAdd(VectorLoadFloat1(&EdgeA[0][Index]), X, VectorMultiplyAdd(VectorLoadFloat1(&EdgeB[0][Index]), Y, VectorLoadFloat1(&EdgeC[0][Index])));
+				const VectorRegister E1 = VectorMultiplyAdd(VectorLoadFloat1(&EdgeA[1][Index]), X, VectorMultiplyAdd(VectorLoadFloat1(&EdgeB[1][Index]), Y, VectorLoadFloat1(&EdgeC[1][Index])));
+				const VectorRegister E2 = VectorMultiplyAdd(VectorLoadFloat1(&EdgeA[2][Index]), X, VectorMultiplyAdd(VectorLoadFloat1(&EdgeB[2][Index]), Y, VectorLoadFloat1(&EdgeC[2][Index])));
+
+				const VectorRegister InTriangle = VectorBitwiseAnd(VectorCompareGE(E0, Zero), VectorBitwiseAnd(VectorCompareGE(E1, Zero), VectorCompareGE(E2, Zero)));
+				Inside = VectorBitwiseOr(Inside, InTriangle);
+
+				// Every lane already inside, no need to check the rest of triangles
+				if ((VectorMaskBits(Inside) & LanesMask) == LanesMask) {
+					break;
+				}
+			}
+			InsideMask = VectorMaskBits(VectorBitwiseAnd(Inside, InBounds)) & LanesMask;
+		}
+
+		for (int32 Lane = 0; Lane < Lanes; ++Lane) {
+			OutInside[Base + Lane] = (InsideMask & (1 << Lane)) != 0;
+			NumInside += OutInside[Base + Lane] ? 1 : 0;
+		}
+	}
+	return NumInside;
+}
+
+int32 FVisibilityFan::ArePointsInside(const TArray<FVector2D>& Points, TArray<bool>& OutInside) const {
+	OutInside.SetNumUninitialized(Points.Num());
+	if (Points.Num() == 0) {
+		return 0;
+	}
+	return ArePointsInside(Points.GetData(), Points.Num(), OutInside.GetData());
+}
+
+float FVisibilityFan::GetSegmentLengthInside(const FVector2D Start, const FVector2D End) const {
+	if (IsEmpty()) {
+		return 0;
+	}
+	FBox2D SegmentBounds(ForceInit);
+	SegmentBounds += Start;
+	SegmentBounds += End;
+	if (!SegmentBounds.Intersect(Bounds)) {
+		return 0;
+	}
+
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister StartX = VectorLoadFloat1(&Start.X);
+	const VectorRegister StartY = VectorLoadFloat1(&Start.Y);
+	const VectorRegister EndX = VectorLoadFloat1(&End.X);
+	const VectorRegister EndY = VectorLoadFloat1(&End.Y);
+
+	// Parameters (0 is Start, 1 is End) where the segment enters and leaves each triangle
+	TArray<FVector2D, TInlineAllocator<16>> Intervals;
+	MS_ALIGN(16) float StartValues[3][4] GCC_ALIGN(16);
+	MS_ALIGN(16) float EndValues[3][4] GCC_ALIGN(16);
+
+	for (int32 Base = 0; Base < Num(); Base += 4) {
+		const int32 Lanes = FMath::Min(4, Num() - Base);
+		const int32 LanesMask = (1 << Lanes) - 1;
+
+		// Edge values of both endpoints for 4 triangles. Unused lanes repeat the last triangle
+		int32 OutsideMask = 0;
+		for (int32 Edge = 0; Edge < 3; ++Edge) {
+			const int32 I1 = Base + FMath::Min(1, Lanes - 1);
+			const int32 I2 = Base + FMath::Min(2, Lanes - 1);
+			const int32 I3 = Base + FMath::Min(3, Lanes - 1);
+			const VectorRegister A = MakeVectorRegister(EdgeA[Edge][Base], EdgeA[Edge][I1], EdgeA[Edge][I2], EdgeA[Edge][I3]);
+			const VectorRegister B = MakeVectorRegister(EdgeB[Edge][Base], EdgeB[Edge][I1], EdgeB[Edge][I2], EdgeB[Edge][I3]);
+			const VectorRegister C = MakeVectorRegister(EdgeC[Edge][Base], EdgeC[Edge][I1], EdgeC[Edge][I2], EdgeC[Edge][I3]);
+
+			const VectorRegister StartValue = VectorMultiplyAdd(A, StartX, VectorMultiplyAdd(B, StartY, C));
+			const VectorRegister EndValue = VectorMultiplyAdd(A, EndX, VectorMultiplyAdd(B, EndY, C));
+			VectorStoreAligned(StartValue, StartValues[Edge]);
+			VectorStoreAligned(EndValue, EndValues[Edge]);
+
+			// Both endpoints on the outer side of an edge: the segment misses the triangle
+			OutsideMask |= VectorMaskBits(VectorBitwiseAnd(VectorCompareGT(Zero, StartValue), VectorCompareGT(Zero, EndValue)));
+		}
+		if ((OutsideMask & LanesMask) == LanesMask) {
+			continue;
+		}
+
+		for (int32 Lane = 0; Lane < Lanes; ++Lane) {
+			if (OutsideMask & (1 << Lane)) {
+				continue;
+			}
+			float Enter = 0;
+			float Exit = 1;
+			for (int32 Edge = 0; Edge < 3 && Enter < Exit; ++Edge) {
+				const float StartValue = StartValues[Edge][Lane];
+				const float EndValue = EndValues[Edge][Lane];
+				if (StartValue >= 0 && EndValue >= 0) {
+					continue;
+				}
+				const float Crossing = StartValue / (StartValue - EndValue);
+				if (StartValue < 0) {
+					Enter = FMath::Max(Enter, Crossing);
+				}
+				else {
+					Exit = FMath::Min(Exit, Crossing);
+				}
+			}
+			if (Enter < Exit) {
+				Intervals.Add(FVector2D(Enter, Exit));
+			}
+		}
+	}
+
+	if (Intervals.Num() == 0) {
+		return 0;
+	}
+
+	// Neighbour triangles share their side edges, merge the overlaps so they are not counted twice
+	Intervals.Sort([](const FVector2D& A, const FVector2D& B) {
+		return A.X < B.X;
+	});
+	float InsideParameter = 0;
+	FVector2D Current = Intervals[0];
+	for (int32 Index = 1; Index < Intervals.Num(); ++Index) {
+		if (Intervals[Index].X <= Current.Y) {
+			Current.Y = FMath::Max(Current.Y, Intervals[Index].Y);
+		}
+		else {
+			InsideParameter += Current.Y - Current.X;
+			Current = Intervals[Index];
+		}
+	}
+	InsideParameter += Current.Y - Current.X;
+
+	return InsideParameter * FVector2D::Distance(Start, End);
+}
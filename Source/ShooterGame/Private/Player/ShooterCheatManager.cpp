@@ -77,4 +77,12 @@ void UShooterCheatManager::SpawnBot()
 		AShooterAIController* ShooterAIController = MyGame->CreateBot(CheatBotNum++);
 		MyGame->RestartPlayer(ShooterAIController);		
 	}
-}
\ No newline at end of file
+}
+
+void UShooterCheatManager::SpawnBots(int32 Count)
+{
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		SpawnBot();
+	}
+}
@@ -6,7 +6,7 @@
 #include "BTTask_FindNearestPoly.generated.h"
 
 /**
- * 
+ * Writes the location of the bot on the navmesh (on its current poly) in the blackboard key
  */
 UCLASS()
 class SHOOTERGAME_API UBTTask_FindNearestPoly : public UBTTask_BlackboardBase
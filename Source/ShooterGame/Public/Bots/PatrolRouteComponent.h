@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "PatrolRouteComponent.generated.h"
+
+/**
+ * Patrol route of a bot: the patrol points attached to its pawn, collected once on possess, and the path of
+ * every leg (point to next point, looping) found once and kept by the navigation system, which repaths them
+ * when the navmesh changes. Moves along a leg reuse its path instead of path finding it again.
+ */
+UCLASS()
+class SHOOTERGAME_API UPatrolRouteComponent : public UActorComponent
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	// Max 2D distance between the move and the ends of a leg to follow its cached path
+	static const int LEG_START_TOLERANCE = 150;
+	static const int LEG_END_TOLERANCE = 50;
+
+	// Patrol points are the actors attached to the pawn with Patrol in their name
+	void CollectWaypoints(const APawn* Pawn);
+	void Reset();
+
+	int32 GetNumWaypoints() const;
+	// Next point of the route, looping. False if the route has no points
+	bool GetNextWaypoint(FVector& OutWaypoint);
+	// Cached path of the leg that goes from around Start to End, NULL if there is none or it is not valid now
+	FNavPathSharedPtr GetLegPath(const FVector Start, const FVector End) const;
+
+private:
+	TArray<FVector> Waypoints;
+	// Path from each waypoint to the next one
+	TArray<FNavPathSharedPtr> LegPaths;
+	int32 NextWaypointIndex;
+
+	void FindLegPaths();
+};
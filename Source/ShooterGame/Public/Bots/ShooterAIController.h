@@ -10,10 +10,12 @@
 #include "Public/Others/AttackPositions.h"
 #include "Public/Others/SearchLocations.h"
 #include "Public/Navigation/MyInfluenceMap.h"
+#include "Public/Navigation/NavPolyTracker.h"
 #include "ShooterAIController.generated.h"
 
 class UBehaviorTreeComponent;
 class UBlackboardComponent;
+class UPatrolRouteComponent;
 
 UENUM(BlueprintType)		//"BlueprintType" is essential to include
 enum class State : uint8
@@ -40,6 +42,10 @@ private:
 	UPROPERTY(transient)
 	UBehaviorTreeComponent* BehaviorComp;
 
+	// Patrol points of the bot and the cached paths between them
+	UPROPERTY(transient)
+	UPatrolRouteComponent* PatrolRoute;
+
 	//----------------------------------------------------------------------//
 	// AI Perception
 	//----------------------------------------------------------------------//
@@ -60,6 +66,7 @@ public:
 	// Begin AController interface
 	virtual void GameHasEnded(class AActor* EndGameFocus = NULL, bool bIsWinner = false) override;
 	virtual void Possess(class APawn* InPawn) override;
+	virtual void UnPossess() override;
 	virtual void BeginInactiveState() override;
 	// End APlayerController interface
 
@@ -72,6 +79,10 @@ public:
 	// Begin AAIController interface
 	/** Update direction AI is looking based on FocalPoint */
 	virtual void UpdateControlRotation(float DeltaTime, bool bUpdatePawn = true) override;
+	/** Path finding moves wait in the navmesh path request queue instead of finding the path in this tick */
+	virtual FAIRequestID RequestPathAndMove(const FAIMoveRequest& MoveRequest, FPathFindingQuery& Query) override;
+	/** Drops the queued path request too */
+	virtual void StopMovement() override;
 	// End AAIController interface
 protected:
 	// Check of we have LOS to a character
@@ -99,8 +110,20 @@ private:
 	const float IM_MOMENTUM = 0.6;
 	const float IM_DECAY = 0.0001;
 
+	// Visibility fans are computed with async traces (ready next frame) instead of blocking the game thread
+	const bool VISIBILITY_ASYNC_TRACES = true;
+	// Moves are path found asynchronously through the navmesh path request queue
+	const bool PATH_REQUEST_QUEUE = true;
+
+	// Crowd avoidance LOD by distance to the closest human. Farther than CROWD_LOD_SIMPLE the bot leaves
+	// the crowd simulation and follows its path segments
+	const float CROWD_LOD_FREQ = 0.5;
+	const float CROWD_LOD_HIGH = 1500;
+	const float CROWD_LOD_GOOD = 3000;
+	const float CROWD_LOD_MEDIUM = 5000;
+	const float CROWD_LOD_SIMPLE = 8000;
+
 	// Temp variables
-	int CurrentPatrolPointIndex = 0;
 	bool NeverSawPlayer = true;
 	
 	float Temp_LookAroundTimer = 0;
@@ -111,9 +134,20 @@ private:
 	float Health_lastValue = 0;
 	float Health_timer = 0;
 
+	float CrowdLOD_timer = 0;
+
+	// Poly of the bot on the navmesh, tracked every update
+	FNavPolyTracker NavPolyTracker;
+	// Last visibility fan of the bot. Rebuilt in place on each update so its arrays are reused
+	FVisibilityFan BotVisibilityFan;
+
 public:
 	/************************* GENERAL **************************/
 
+	// Location of the bot on the navmesh, from its poly tracker. False if it is off the navmesh
+	bool UpdateNavLocation(FNavLocation& OutNavLocation);
+	const FNavPolyTracker& GetNavPolyTracker() const;
+
 	State GetAI_State() const;
 	void SetAI_State(const State AI_State);
 	
@@ -222,6 +256,7 @@ public:
 	void UpdateBotState();
 	void UpdateHealthSituation(const float DeltaSeconds);
 	void UpdateWeaponStats();
+	void UpdateCrowdLOD(const float DeltaSeconds);
 
 	void UpdatePlayerVisibility();
 	void UpdatePlayerIsClose();
@@ -231,6 +266,10 @@ public:
 	void UpdateTacticalAttackSituation();
 
 private:
+	void OnBotVisibilityCalculated(TArray<Triangle>& VisibleTriangles);
+	// Fight moves are found first, then search moves, then patrol
+	int32 GetPathRequestPriority() const;
+
 	bool PositionIsSafeCover(const FVector CoverPosition, const FVector PlayerPosition) const;
 	bool PositionIsGoodAttack(const FVector AttackPosition, const FVector PlayerPosition) const;
 };
\ No newline at end of file
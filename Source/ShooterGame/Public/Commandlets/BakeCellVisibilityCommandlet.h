@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "BakeCellVisibilityCommandlet.generated.h"
+
+/**
+ * Bakes the cell to cell visibility of the navigable area of a map at eyes height.
+ * Usage: UE4Editor-Cmd ShooterGame -run=BakeCellVisibility -Map=/Game/Maps/Sanctuary [-CellSize=100]
+ */
+UCLASS()
+class SHOOTERGAME_API UBakeCellVisibilityCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "BakeCoverTravelCommandlet.generated.h"
+
+/**
+ * Bakes the travel times between every pair of cover annotations and navmesh grid points of a map (UCoverTravelData).
+ * Usage: UE4Editor-Cmd ShooterGame -run=BakeCoverTravel -Map=/Game/Maps/Sanctuary [-Spacing=1000] [-WalkSpeed=600]
+ */
+UCLASS()
+class SHOOTERGAME_API UBakeCoverTravelCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "BakeNavTilesCommandlet.generated.h"
+
+/**
+ * Writes the navmesh tiles of a map to its tile blob (FNavTileBlob), mapped by the navmesh at runtime.
+ * Usage: UE4Editor-Cmd ShooterGame -run=BakeNavTiles -Map=/Game/Maps/Sanctuary
+ */
+UCLASS()
+class SHOOTERGAME_API UBakeNavTilesCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	virtual int32 Main(const FString& Params) override;
+};
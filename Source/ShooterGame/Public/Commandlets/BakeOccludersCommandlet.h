@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "BakeOccludersCommandlet.generated.h"
+
+/**
+ * Bakes the 2D footprints of all the collision that blocks visibility in a map and does not move:
+ * static and unsimulated movable components, additive BSP brushes and the bounds of the cover actors.
+ * Usage: UE4Editor-Cmd ShooterGame -run=BakeOccluders -Map=/Game/Maps/Sanctuary [-MinHeight=50]
+ */
+UCLASS()
+class SHOOTERGAME_API UBakeOccludersCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	virtual int32 Main(const FString& Params) override;
+};
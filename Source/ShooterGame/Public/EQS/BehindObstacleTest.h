@@ -14,4 +14,8 @@ class SHOOTERGAME_API UBehindObstacleTest : public UEnvQueryTest
 	GENERATED_UCLASS_BODY()
 
 	virtual void RunTest(FEnvQueryInstance& QueryInstance) const override;
+
+private:
+	// Baked line of sight when available, trace otherwise
+	bool IsBlocked(UWorld * World, FHitResult &OutHit, const FVector From, const FVector To, const FCollisionQueryParams &CollisionParams) const;
 };
@@ -16,6 +16,10 @@ class SHOOTERGAME_API UCloserHighInfluencePositionsTest : public UEnvQueryTest
 	UPROPERTY(EditDefaultsOnly, Category = "Score")
 	bool UseAverage = false;
 
+	// Score multiplier of the items on tiles some bot already searched since the player was last seen
+	UPROPERTY(EditDefaultsOnly, Category = "Score")
+	float SearchedTileWeight = 0.5f;
+
 	virtual void RunTest(FEnvQueryInstance& QueryInstance) const override;
 
 };
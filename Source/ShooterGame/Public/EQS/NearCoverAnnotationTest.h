@@ -12,6 +12,14 @@ UCLASS()
 class SHOOTERGAME_API UNearCoverAnnotationTest : public UEnvQueryTest
 {
 	GENERATED_UCLASS_BODY()
+	// Without context any cover annotation within MaxDistance passes. With one, one of the closest annotations
+	// must have its cover between it and the context
+	UPROPERTY(EditDefaultsOnly, Category = Cover)
+	TSubclassOf<UEnvQueryContext> Context;
+
+	UPROPERTY(EditDefaultsOnly, Category = Cover)
+	float MaxDistance = 200.0f;
+
 	virtual void RunTest(FEnvQueryInstance& QueryInstance) const override;
 	virtual void PostLoad() override;
 };
@@ -30,6 +30,10 @@ class SHOOTERGAME_API UPathfiningTest : public UEnvQueryTest
 	UPROPERTY(EditDefaultsOnly, Category = Pathfinding)
 		TSubclassOf<UNavigationQueryFilter> FilterClass;
 
+	/** PathExist and PathLength read the baked cover travel table (UCoverTravelData) when item and context snap to its waypoints */
+	UPROPERTY(EditDefaultsOnly, Category = Pathfinding)
+		bool bUseCoverTravelTable;
+
 	virtual void RunTest(FEnvQueryInstance& QueryInstance) const override;
 
 	virtual FText GetDescriptionTitle() const override;
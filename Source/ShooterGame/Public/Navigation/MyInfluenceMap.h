@@ -2,6 +2,8 @@
 
 #pragma once
 #include "Public/Navigation/MyTexture2D.h"
+#include "Public/Others/HelperMethods.h"
+#include "Public/Others/ShadowCastingFOV.h"
 #include "MyInfluenceMap.generated.h"
 
 struct InfluenceTile {
@@ -34,8 +36,14 @@ private:
 	MyTexture2D* BaseTexture;
 	MyTexture2D* UpdatedTexture;
 
-	// Temp
-	TMap<FString, TArray<Triangle>> * BotsVisibilities;
+	// Field of view over the tiles, non walkable tiles block the view
+	FShadowCastingFOV TilesFOV;
+	// Tiles currently seen by each bot
+	TMap<FString, TArray<int32>> BotsVisibleTiles;
+	// Number of bots seeing each tile
+	TArray<uint8> TilesVisibleCount;
+	// Tiles seen by any bot since the player was last seen
+	TBitArray<> SearchedTiles;
 
 	float TempTimer = 0;
 public:
@@ -52,7 +60,14 @@ public:
 	TArray<InfluenceTile*> GetWalkableNeighbors(const int Index);
 
 
-	void SetBotVisibility(FString BotName, TArray<Triangle> Visibility);
+	// Tiles visible from the bot eyes (shadow casting over the walkable tiles) inside its view cone
+	void SetBotVisibility(const FString& BotName, const FVector Location, const FVector ForwardVector, const float ViewAngle = HelperMethods::PLAYER_FOV, const float ViewDistance = HelperMethods::PLAYER_DV);
+	void RemoveBotVisibility(const FString& BotName);
+
+	// Searched area bookkeeping: walkable tiles already seen by some bot
+	bool TileWasSearched(const int Index) const;
+	// The player was seen, the search starts over
+	void ClearSearchedTiles();
 
 	bool SetInfluence(const int X, const int Y, const float NewInfluence, const float DeltaTime = 0);
 	bool SetInfluence(const int index, const float NewInfluence, const float DeltaTime = 0);
@@ -6,9 +6,25 @@
 #include "Runtime/Navmesh/Public/Detour/DetourNavMesh.h"
 #include "AI/Navigation/PImplRecastNavMesh.h"
 #include "AI/Navigation/RecastNavMesh.h"
+#include "Public/Others/VisibilityFan.h"
+#include "Public/Others/VisibilityCoverage.h"
+#include "Public/Others/OcclusionHeightGrid.h"
+#include "Public/Others/OccupancyGrid.h"
+#include "Public/Others/CoverAnnotationIndex.h"
+#include "Public/Navigation/ThreatField.h"
+#include "Public/Navigation/NavFlowField.h"
+#include "Public/Navigation/NavPathCache.h"
+#include "Public/Navigation/NavIncrementalPlanner.h"
+#include "Public/Navigation/NavClusterGraph.h"
+#include "Public/Navigation/NavPathRequestQueue.h"
+#include "Public/Navigation/NavTileBlob.h"
 
 #include "MyRecastNavMesh.generated.h"
 
+class UCellVisibilityData;
+class UCoverTravelData;
+class UOccluderSegmentData;
+
 class Triangle {
 public:
 	FVector V1;
@@ -88,9 +104,15 @@ public:
 	static const int UPDATE_FREQ = 1; // Seconds 
 	static const int MAX_COST = 5000; // Cost of most dangerous area (player location)
 		
-	static bool SetPlayerVisibility(const TArray<Triangle> VisibleAreas);
+	// Where the threat fields come from (the navmesh of the world)
+	void SetThreatPublisher(const FThreatFieldPublisherPtr& Publisher);
+	// Takes the latest threat field of the publisher. Costs only read the captured one
+	void CaptureThreatField();
+	const FThreatFieldPtr& GetThreatField() const;
+
 private:
-	static TArray<Triangle> PlayerVisibleAreas;
+	FThreatFieldPublisherPtr ThreatPublisher;
+	FThreatFieldPtr ThreatField;
 
 public:
 	dtQueryFilter_Example(bool inIsVirtual = true) : dtQueryFilter(inIsVirtual)
@@ -110,9 +132,6 @@ private:
 	float GetCostOfPosition(const FVector2D Position) const;
 	bool PositionIsVisibleByPlayer(const FVector2D Position) const;
 
-	float GetCustomCost(const FVector2D StartPosition, const FVector2D EndPosition) const;
-
-	FVector2D GetMinimumVector(const FVector2D StartPosition, const FVector2D EndPosition) const;
 };
 
 /**
@@ -155,17 +174,143 @@ class SHOOTERGAME_API AMyRecastNavMesh : public ARecastNavMesh
 	GENERATED_BODY()
 
 public:
+	// Write the threat field in the areas of the polys (UNavArea_Exposed, UNavArea_PartiallyExposed) and path with
+	// the non virtual filter, so the danger comes from the area costs instead of getVirtualCost
+	static const bool THREAT_AREAS = false;
+	// Move requests of the controllers are planned with a D* Lite planner per agent. When the threats change
+	// the paths crossing them are invalidated and the repath only repairs the planner
+	static const bool INCREMENTAL_REPLANNING = true;
+	// Replace the tiles serialized in the level by the cooked tile blob of the map (FNavTileBlob) when there is one.
+	// Only for navmeshes that are not rebuilt on load (bForceRebuildOnLoad)
+	static const bool MAPPED_TILES = true;
+	// Paths longer than FNavClusterGraph::MIN_DISTANCE are searched on the tiles graph and refined in the tiles
+	// crossed. The graph is re-costed where the threats changed
+	static const bool CLUSTER_GRAPH = true;
+
 	AMyRecastNavMesh(const FObjectInitializer& ObjectInitializer);
 	FRecastQueryFilter_Example* GetCustomFilter() const;
+	// Baked cell visibility of the map (NULL if the map has not been baked)
+	UCellVisibilityData* GetCellVisibility() const;
+	// Baked travel times between the cover annotations (NULL if the map has not been baked)
+	UCoverTravelData* GetCoverTravel() const;
+	// Baked footprints of the static collision (NULL if the map has not been baked)
+	UOccluderSegmentData* GetOccluders() const;
+	// Built from the occluders on BeginPlay (NULL without occluders)
+	const FOcclusionHeightGrid* GetOcclusionHeightGrid() const;
+	// Occupancy at eyes height, built from the occluders on BeginPlay (NULL without occluders)
+	const FOccupancyGrid* GetOccupancyGrid() const;
+	// Cover annotations of the level, indexed on BeginPlay
+	const FCoverAnnotationIndex& GetCoverAnnotations() const;
+
+	// Navigation filters capture the latest player visibility from here
+	void PublishPlayerVisibility(const TSharedPtr<const FVisibilityFan, ESPMode::ThreadSafe>& PlayerVisibility);
+	const FThreatFieldPublisherPtr& GetThreatPublisher() const;
+
+	// Each path query runs with its own copy of the filter that captures the latest threat field.
+	// Corridors are cached per start and end polys, filter and threat version
+	static FPathFindingResult FindPath(const FNavAgentProperties& AgentProperties, const FPathFindingQuery& Query);
+	// Short moves of the controllers with the navmesh filter, repaired from the planner of the agent. Game thread only
+	bool FindIncrementalPath(const FPathFindingQuery& Query, const dtPolyRef StartPoly, FPathFindingResult& OutResult) const;
+	// Hit rate and size of the path cache
+	const FNavPathCache& GetPathCache() const;
+	const FNavClusterGraph& GetClusterGraph() const;
+	// Moves of the bots wait here for the asynchronous path finding, processed every tick
+	FNavPathRequestQueue& GetPathRequestQueue();
+
+	// Flow field from Source under the navmesh filter, cached per source poly and threat version. NULL if Source is not on the navmesh
+	TSharedPtr<const FNavFlowField> GetFlowField(const FVector Source);
+	// Poly of a location for the flow field lookups (0 if it is not on the navmesh)
+	dtPolyRef GetFlowFieldPoly(const FVector Location) const;
+
+	// Team coverage: union of the visibility fans of every pawn of a team
+	void UpdateObserverCoverage(const APawn * Observer, const FVisibilityFan& Fan);
+	void RemoveObserverCoverage(const APawn * Observer);
+	// Seen by any pawn that is not in Team
+	bool IsPointCoveredByEnemies(const int32 Team, const FVector Point) const;
+	float GetSegmentCoverageByEnemies(const int32 Team, const FVector From, const FVector To) const;
 
 private:
 	float Timer;
 	FRecastQueryFilter_Example DefaultNavFilter;
 
+	UPROPERTY(transient)
+	UCellVisibilityData* CellVisibility;
+	UPROPERTY(transient)
+	UCoverTravelData* CoverTravel;
+	UPROPERTY(transient)
+	UOccluderSegmentData* Occluders;
+
+	FThreatFieldPublisherPtr ThreatPublisher;
+	TSharedPtr<FNavPathCache, ESPMode::ThreadSafe> PathCache;
+	TSharedPtr<FNavPathRequestQueue> PathRequestQueue;
+	// Version of the threat field written in the poly areas
+	uint32 ThreatAreasVersion;
+	// Frames the request queue has been held waiting for the in flight queries
+	int32 ThreatAreasHeldFrames;
+	// Original area of the polys tagged as exposed
+	TMap<dtPolyRef, uint8> ThreatTaggedPolys;
+
+	static const int MAX_FLOW_FIELDS = 8;
+	// Most recently used last
+	TArray<TSharedPtr<const FNavFlowField>> FlowFields;
+
+	struct FAgentPlanner {
+		TSharedPtr<FNavIncrementalPlanner> Planner;
+		// Player visibility bounds of the threat field the planner costs come from
+		FBox2D ThreatBounds;
+		// Last path filled from the planner and the area it walks through
+		FNavPathWeakPtr Path;
+		FBox2D PathBounds;
+	};
+	// Only touched on the game thread (FindPath falls back to detour elsewhere)
+	mutable TMap<TWeakObjectPtr<const UObject>, FAgentPlanner> AgentPlanners;
+	uint32 AgentPlannersVersion;
+
+	// Long paths, queried from any thread
+	TSharedPtr<FNavClusterGraph, ESPMode::ThreadSafe> ClusterGraph;
+	// Rebuilt on the next tick (the tiles changed). Not searched meanwhile, its corridors go through the old polys
+	bool bClusterGraphDirty;
+	// Tiles changed since the last rebuild, only their clusters are rebuilt
+	TArray<uint32> ClusterGraphTiles;
+	// Player visibility bounds of the threat field the graph costs come from
+	FBox2D ClusterGraphThreatBounds;
+
+	// Mapped tiles, must outlive them in the detour navmesh
+	TSharedPtr<FNavTileBlob> TileBlob;
+
+	TSharedPtr<FOcclusionHeightGrid> OcclusionHeightGrid;
+	TSharedPtr<FOccupancyGrid> OccupancyGrid;
+	FCoverAnnotationIndex CoverAnnotations;
+
+	TMap<int32, TSharedPtr<FVisibilityCoverageGrid>> TeamsCoverage;
+	FBox2D CoverageBounds;
+
 protected:
 	virtual void Tick(float deltaTime) override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void OnNavMeshTilesUpdated(const TArray<uint32>& ChangedTiles) override;
 
 private:
 	void SetupCustomNavFilter();
+	void LoadMappedTiles();
+	// Writes the latest threat version in the poly areas. Returns false while the queue has to wait for the workers
+	bool UpdateThreatAreas();
+	void UpdateClusterGraph();
+	// Version of the threat costs the paths are found with (threat field or tagged areas)
+	uint32 GetThreatVersion() const;
+	// Bounds of the latest player visibility (invalid without any)
+	FBox2D GetThreatBounds() const;
+	// Copy of the navmesh filter with the latest threat field captured
+	TSharedPtr<FRecastQueryFilter_Example> CreateThreatFilter() const;
+	// Copy of the navmesh filter without any threat field (corridors of the cluster graph)
+	TSharedPtr<FRecastQueryFilter_Example> CreateBaseFilter() const;
+
+	bool FindIncrementalCorridor(const FPathFindingQuery& Query, const dtPolyRef StartPoly, const dtPolyRef EndPoly, FNavCachedCorridor& OutCorridor) const;
+	// Keeps the path of a controller move to invalidate it when the threats on it change
+	void TrackAgentPath(const UObject* Owner, const FNavPathSharedPtr& Path) const;
+	// Paths found by the workers for the request queue are tracked on the game thread
+	void OnQueuedPathFound(const UObject* Owner, const FNavPathSharedPtr& Path);
+	// Invalidates the planned paths crossing the threats that changed, so their agents repath
+	void InvalidateAgentPaths();
 };
\ No newline at end of file
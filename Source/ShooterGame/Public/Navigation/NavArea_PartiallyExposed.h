@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "AI/Navigation/NavAreas/NavArea.h"
+#include "NavArea_PartiallyExposed.generated.h"
+
+/**
+ * Navmesh polys partially seen by the player (tagged by AMyRecastNavMesh when THREAT_AREAS is on)
+ */
+UCLASS()
+class SHOOTERGAME_API UNavArea_PartiallyExposed : public UNavArea
+{
+	GENERATED_UCLASS_BODY()
+};
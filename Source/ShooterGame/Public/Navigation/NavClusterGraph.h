@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Runtime/Navmesh/Public/Detour/DetourNavMesh.h"
+#include "Runtime/Navmesh/Public/Detour/DetourNavMeshQuery.h"
+
+/**
+ * Abstract graph of the navmesh for long paths (HPA*). Clusters are the navmesh tiles and entrances the
+ * portals between polys of different tiles. The polys between every two entrances of a cluster are precomputed
+ * without threats (BaseFilter) and only change with the tiles. Each threat version re-costs the stored corridors
+ * of the clusters the player visibility changed over with the threat filter, as a surcharge added to the edge cost,
+ * so no cluster is searched again. A long path is searched over the entrances and refined with the precomputed
+ * polys of each cluster crossed, so only the start and end clusters are searched poly by poly (with the threats).
+ * Queries can come from any thread, updates are done on the game thread. A published graph is never modified:
+ * updates build a new one sharing the clusters that did not change, and queries search the graph they started
+ * with without holding the lock.
+ */
+class SHOOTERGAME_API FNavClusterGraph
+{
+public:
+	// Paths shorter than this are found on the polys directly
+	static const int MIN_DISTANCE = 5000;
+	// Max polys of the paths between the entrances of a cluster
+	static const int MAX_CLUSTER_CORRIDOR = 256;
+
+	FNavClusterGraph();
+
+	// BaseFilter finds the corridors of the clusters, Filter adds the threats. Each graph must get its own copies
+	void Build(const dtNavMesh* DetourMesh, const TSharedPtr<const dtQueryFilter>& BaseFilter, const TSharedPtr<const dtQueryFilter>& Filter, const uint32 FilterVersion);
+	// Rebuilds the clusters of ChangedTiles and the entrances of their neighbours, and re-costs the clusters
+	// overlapping ChangedArea with the new threat version. Builds the whole graph if it was not built
+	void RebuildTiles(const dtNavMesh* DetourMesh, const TArray<uint32>& ChangedTiles, const TSharedPtr<const dtQueryFilter>& BaseFilter, const TSharedPtr<const dtQueryFilter>& Filter, const uint32 FilterVersion, const FBox2D& ChangedArea);
+	// Re-costs the corridors of the clusters overlapping ChangedArea with a new threat version
+	void UpdateFilter(const TSharedPtr<const dtQueryFilter>& NewBaseFilter, const TSharedPtr<const dtQueryFilter>& NewFilter, const uint32 NewFilterVersion, const FBox2D& ChangedArea);
+	bool IsBuilt() const;
+	uint32 GetFilterVersion() const;
+	int32 GetNumClusters() const;
+	int32 GetNumEntrances() const;
+
+	// Polys from StartPoly to EndPoly through the entrances. False if there is no path in the graph or both
+	// polys are in the same cluster. The surcharge of each edge crossed is added to the cost of its last poly
+	bool FindCorridor(const dtPolyRef StartPoly, const FVector StartLocation, const dtPolyRef EndPoly, const FVector EndLocation, TArray<NavNodeRef>& OutCorridor, TArray<float>& OutCorridorCost) const;
+
+private:
+	// Portal between two polys of different clusters
+	struct FClusterEntrance {
+		FVector Position;
+		dtPolyRef Polys[2];
+		int32 Clusters[2];
+
+		dtPolyRef GetPolyIn(const int32 Cluster) const {
+			return Clusters[0] == Cluster ? Polys[0] : Polys[1];
+		}
+		bool IsRemoved() const {
+			return Clusters[0] == INDEX_NONE;
+		}
+	};
+
+	// Path inside a cluster between two of its entrances, found and costed without threats
+	struct FClusterEdge {
+		int32 From;
+		int32 To;
+		float Cost;
+		// From the poly of From to the poly of To in the cluster, with the cost of leaving each one
+		TArray<NavNodeRef> Corridor;
+		TArray<float> CorridorCost;
+		// Where the corridor enters each poly, to cost it again with the threats
+		TArray<FVector> CorridorEntries;
+	};
+
+	struct FCluster {
+		FBox2D Bounds;
+		TArray<int32> Entrances;
+		TArray<FClusterEdge> Edges;
+	};
+	typedef TSharedPtr<FCluster, ESPMode::ThreadSafe> FClusterPtr;
+	typedef TMap<int32, FClusterPtr> FClusterMap;
+	// Threat cost added to each edge of a cluster, in the order of its edges
+	typedef TSharedPtr<const TArray<float>, ESPMode::ThreadSafe> FSurchargesPtr;
+
+	// Open list entry of the searches, on polys inside a cluster or on the entrances
+	template<typename IndexType>
+	struct FSearchEntry {
+		float Cost;
+		IndexType Index;
+
+		FSearchEntry() : Cost(0), Index(0) {}
+		FSearchEntry(const float Cost, const IndexType Index) : Cost(Cost), Index(Index) {}
+
+		bool operator<(const FSearchEntry& Other) const {
+			return Cost < Other.Cost;
+		}
+	};
+
+	// Entrance reached by the search on the graph
+	struct FEntranceSearchNode {
+		float Cost;
+		// Edge the entrance was reached through (INDEX_NONE from the start cluster)
+		int32 ParentCluster;
+		int32 ParentEdge;
+	};
+
+	// Poly by poly search inside a cluster
+	struct FClusterSearchNode {
+		float Cost;
+		dtPolyRef Parent;
+		// Where the path enters the poly
+		FVector Entry;
+	};
+
+	struct FGraph {
+		const dtNavMesh* DetourMesh;
+		// Only this graph holds its filters, the references of the filters are not thread safe
+		TSharedPtr<const dtQueryFilter> BaseFilter;
+		TSharedPtr<const dtQueryFilter> Filter;
+		uint32 FilterVersion;
+		// Clusters of a published graph are never modified, the next graphs share them
+		FClusterMap Clusters;
+		// Same for the surcharges, clusters without any have no threat on their corridors
+		TMap<int32, FSurchargesPtr> Surcharges;
+		// Removed entrances leave a hole for the next ones, the clusters keep the indexes of theirs
+		TArray<FClusterEntrance> Entrances;
+		TArray<int32> FreeEntrances;
+
+		FGraph(const dtNavMesh* DetourMesh, const TSharedPtr<const dtQueryFilter>& BaseFilter, const TSharedPtr<const dtQueryFilter>& Filter, const uint32 FilterVersion);
+		// Clusters, entrances and surcharges of Other with other filters
+		FGraph(const FGraph& Other, const TSharedPtr<const dtQueryFilter>& BaseFilter, const TSharedPtr<const dtQueryFilter>& Filter, const uint32 FilterVersion);
+
+		int32 GetCluster(const dtPolyRef PolyRef) const;
+		float GetSegmentCost(const dtQueryFilter& QueryFilter, const FVector From, const FVector To, const dtPolyRef PolyRef) const;
+		// Dijkstra over the polys of Cluster from StartPoly
+		void SearchCluster(const dtQueryFilter& QueryFilter, const int32 Cluster, const dtPolyRef StartPoly, const FVector StartLocation, TMap<dtPolyRef, FClusterSearchNode>& OutNodes) const;
+		// Cost from the start of the search to Location in PolyRef (BIG_NUMBER if it was not reached)
+		float GetSearchCost(const dtQueryFilter& QueryFilter, const TMap<dtPolyRef, FClusterSearchNode>& Nodes, const dtPolyRef PolyRef, const FVector Location) const;
+		// Polys from the start of the search to PolyRef, with the cost of leaving each one towards Location
+		bool GetSearchCorridor(const dtQueryFilter& QueryFilter, const TMap<dtPolyRef, FClusterSearchNode>& Nodes, const dtPolyRef PolyRef, const FVector Location, TArray<NavNodeRef>& OutCorridor, TArray<float>& OutCorridorCost) const;
+		bool FindCorridor(const dtPolyRef StartPoly, const FVector StartLocation, const dtPolyRef EndPoly, const FVector EndLocation, TArray<NavNodeRef>& OutCorridor, TArray<float>& OutCorridorCost) const;
+
+		int32 AddEntrance(const FClusterEntrance& Entrance);
+		void RemoveEntrance(const int32 EntranceIndex);
+		// Cluster being rebuilt, a copy of the published one without its edges the first time
+		FCluster& GetRebuiltCluster(const int32 ClusterIndex, FClusterMap& Rebuilt) const;
+		// Entrances from the polys of the tile to the other clusters. The ones to the tiles in Rebuilt are only
+		// added from their lowest poly, the tile of the other poly adds them
+		void AddTileEntrances(const int32 TileIndex, const TSet<int32>& RebuiltTiles, FClusterMap& Rebuilt, TMap<dtPolyRef, TArray<int32>>& PolyEntrances);
+		void BuildClusterEdges(const int32 ClusterIndex, FCluster& Cluster) const;
+		// Threat cost of the stored corridors of the cluster over their base cost, one walk along each corridor
+		void UpdateSurcharges(const int32 ClusterIndex);
+		float GetSurcharge(const int32 ClusterIndex, const int32 EdgeIndex) const;
+	};
+	typedef TSharedPtr<FGraph, ESPMode::ThreadSafe> FGraphPtr;
+
+	// Latest graph, the queries take a reference
+	FGraphPtr Graph;
+	mutable FCriticalSection Lock;
+
+	TSharedPtr<const FGraph, ESPMode::ThreadSafe> GetGraph() const;
+	// Rebuilds the clusters of the tiles and their neighbours, re-costs the ones overlapping ChangedArea, and publishes the graph
+	void Rebuild(const FGraphPtr& NewGraph, const TSet<int32>& ChangedTiles, const FBox2D& ChangedArea);
+};
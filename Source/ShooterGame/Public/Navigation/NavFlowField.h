@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Runtime/Navmesh/Public/Detour/DetourNavMesh.h"
+#include "Runtime/Navmesh/Public/Detour/DetourNavMeshQuery.h"
+
+/**
+ * Single source navmesh distance field: Dijkstra over the polys from one location under one filter.
+ * Every reachable poly keeps its cost, path length and parent towards the source, so the cost or the length
+ * of the path between the source and any location is a lookup.
+ * Costs are the same in both directions with the threat filter (exposed length does not depend on the direction).
+ */
+class SHOOTERGAME_API FNavFlowField
+{
+public:
+	FNavFlowField(const dtPolyRef SourcePoly, const FVector SourceLocation, const uint32 FilterVersion);
+
+	// Expands every poly reachable from the source. The field keeps the navmesh and the filter for its queries
+	void Build(const dtNavMesh* DetourMesh, const TSharedPtr<const dtQueryFilter>& Filter);
+
+	dtPolyRef GetSourcePoly() const;
+	uint32 GetFilterVersion() const;
+
+	bool IsReachable(const dtPolyRef PolyRef) const;
+	// BIG_NUMBER if the poly is not reachable
+	float GetCost(const dtPolyRef PolyRef, const FVector Location) const;
+	float GetLength(const dtPolyRef PolyRef, const FVector Location) const;
+
+private:
+	struct FFlowNode {
+		float Cost;
+		float Length;
+		dtPolyRef Parent;
+		// Where the path enters the poly (portal middle point, source location for the source poly)
+		FVector Entry;
+	};
+
+	const dtPolyRef SourcePoly;
+	const FVector SourceLocation;
+	const uint32 FilterVersion;
+
+	const dtNavMesh* DetourMesh;
+	TSharedPtr<const dtQueryFilter> Filter;
+	TMap<dtPolyRef, FFlowNode> Nodes;
+
+	float GetSegmentCost(const FVector From, const FVector To, const dtPolyRef PolyRef) const;
+};
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Runtime/Navmesh/Public/Detour/DetourNavMesh.h"
+#include "Runtime/Navmesh/Public/Detour/DetourNavMeshQuery.h"
+
+/**
+ * D* Lite over the navmesh polys for one agent and one goal. The search runs backwards from the goal, so
+ * the agent can move along its corridor, and its state is kept between plans: when the threat costs change
+ * only the polys inside the changed area are updated and re-expanded, then the corridor is repaired.
+ * Polys are connected through the middle of their shared edges and costed with the detour filter
+ * (centroid to portal to centroid), so edge costs do not depend on the path.
+ * Not thread safe, planners live on the game thread.
+ */
+class SHOOTERGAME_API FNavIncrementalPlanner
+{
+public:
+	// Expansions allowed per plan before giving up (the caller falls back to a regular query)
+	static const int MAX_EXPANSIONS = 8192;
+
+	FNavIncrementalPlanner(const dtNavMesh* DetourMesh, const TSharedPtr<const dtQueryFilter>& Filter, const dtPolyRef StartPoly, const dtPolyRef GoalPoly, const uint32 FilterVersion);
+
+	dtPolyRef GetGoalPoly() const;
+	uint32 GetFilterVersion() const;
+	// Polys expanded since the planner was created, repairs only add a few
+	int32 GetNumExpanded() const;
+
+	// The agent is now at NewStartPoly
+	void SetStart(const dtPolyRef NewStartPoly);
+	// New costs (i.e. new threat field). Only the edges with a poly overlapping ChangedArea are re-costed
+	void UpdateFilter(const TSharedPtr<const dtQueryFilter>& NewFilter, const uint32 NewFilterVersion, const FBox2D& ChangedArea);
+
+	// Repairs the search and returns the polys from the start to the goal. False if the goal is not reachable
+	bool GetCorridor(TArray<NavNodeRef>& OutCorridor, TArray<float>& OutCorridorCost);
+
+private:
+	struct FPlannerEdge {
+		dtPolyRef Neighbour;
+		// Middle of the shared edge
+		FVector Portal;
+		float Cost;
+	};
+
+	struct FPlannerNode {
+		float G;
+		float Rhs;
+		FVector Position;
+		FBox2D Bounds;
+		// Key in the open list (only valid while bOpen)
+		FVector2D Key;
+		bool bOpen;
+		bool bEdgesBuilt;
+		TArray<FPlannerEdge, TInlineAllocator<6>> Edges;
+	};
+
+	struct FOpenEntry {
+		FVector2D Key;
+		dtPolyRef PolyRef;
+
+		FOpenEntry() : Key(0, 0), PolyRef(0) {}
+		FOpenEntry(const FVector2D Key, const dtPolyRef PolyRef) : Key(Key), PolyRef(PolyRef) {}
+
+		bool operator<(const FOpenEntry& Other) const {
+			return Key.X < Other.Key.X || (Key.X == Other.Key.X && Key.Y < Other.Key.Y);
+		}
+	};
+
+	const dtNavMesh* DetourMesh;
+	TSharedPtr<const dtQueryFilter> Filter;
+	uint32 FilterVersion;
+
+	const dtPolyRef GoalPoly;
+	dtPolyRef StartPoly;
+	dtPolyRef LastStartPoly;
+	float KeyModifier;
+	int32 NumExpanded;
+
+	TMap<dtPolyRef, FPlannerNode> Nodes;
+	TArray<FOpenEntry> OpenList;
+
+	FPlannerNode& GetNode(const dtPolyRef PolyRef);
+	// Neighbours are added to the nodes, so node references do not survive this call
+	void BuildEdges(const dtPolyRef PolyRef);
+	float GetSegmentCost(const FVector From, const FVector To, const dtPolyRef PolyRef) const;
+	float GetEdgeCost(const dtPolyRef From, const dtPolyRef To, const FVector Portal) const;
+	float GetHeuristic(const dtPolyRef From, const dtPolyRef To) const;
+	FVector2D CalculateKey(const dtPolyRef PolyRef) const;
+	void UpdateVertex(const dtPolyRef PolyRef);
+	bool ComputeShortestPath();
+};
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Runtime/Navmesh/Public/Detour/DetourNavMesh.h"
+
+struct FNavPathCacheKey
+{
+	dtPolyRef StartPoly;
+	dtPolyRef EndPoly;
+	// Shared filter of the query (one per filter class and navmesh)
+	const void* Filter;
+	uint32 ThreatVersion;
+
+	FNavPathCacheKey(const dtPolyRef StartPoly, const dtPolyRef EndPoly, const void* Filter, const uint32 ThreatVersion)
+		: StartPoly(StartPoly), EndPoly(EndPoly), Filter(Filter), ThreatVersion(ThreatVersion) {}
+
+	bool operator==(const FNavPathCacheKey& Other) const {
+		return StartPoly == Other.StartPoly && EndPoly == Other.EndPoly && Filter == Other.Filter && ThreatVersion == Other.ThreatVersion;
+	}
+
+	friend uint32 GetTypeHash(const FNavPathCacheKey& Key) {
+		return HashCombine(HashCombine(GetTypeHash(Key.StartPoly), GetTypeHash(Key.EndPoly)), HashCombine(PointerHash(Key.Filter), Key.ThreatVersion));
+	}
+};
+
+// Polys of a found path and the cost of each of them
+struct FNavCachedCorridor
+{
+	TArray<NavNodeRef> Corridor;
+	TArray<float> CorridorCost;
+};
+
+/**
+ * Least recently used cache of path corridors. Entries of older threat versions are never hit again
+ * and get evicted as new ones come. Thread safe, paths can be found on any thread
+ */
+class SHOOTERGAME_API FNavPathCache
+{
+public:
+	static const int DEFAULT_CAPACITY = 256;
+
+	FNavPathCache(const int32 Capacity = DEFAULT_CAPACITY);
+
+	bool Find(const FNavPathCacheKey& Key, FNavCachedCorridor& OutCorridor);
+	void Add(const FNavPathCacheKey& Key, const FNavCachedCorridor& Corridor);
+	void Empty();
+
+	int32 Num() const;
+	uint32 GetHits() const;
+	uint32 GetMisses() const;
+	float GetHitRate() const;
+
+private:
+	struct FEntry {
+		FNavCachedCorridor Corridor;
+		uint64 LastUse;
+	};
+
+	mutable FCriticalSection Lock;
+	TMap<FNavPathCacheKey, FEntry> Entries;
+	const int32 Capacity;
+	uint64 UseCounter;
+	uint32 Hits;
+	uint32 Misses;
+};
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "AI/Navigation/NavigationSystem.h"
+
+// Path of a queued request found by a worker, told on the game thread
+DECLARE_DELEGATE_TwoParams(FOnQueuedPathFound, const UObject* /*Owner*/, const FNavPathSharedPtr& /*Path*/);
+
+/**
+ * Path requests of the bots. Requests wait here with a priority and a few of them are handed every frame
+ * to the asynchronous path finding of the navigation system (worker thread), so a burst of moves is spread
+ * over the next frames instead of path finding all of them in the same tick.
+ * The path of each request is the one the path following is waiting for: it is filled by the worker and
+ * its observers are told when it is ready (or that it failed).
+ * The start poly of each request is resolved on the game thread when it is queued, the workers read it with
+ * GetDispatchedStartPoly. Everything else is game thread only.
+ */
+class SHOOTERGAME_API FNavPathRequestQueue : public TSharedFromThis<FNavPathRequestQueue>
+{
+public:
+	// Requests handed to the workers per frame, and max requests being computed at the same time
+	static const int MAX_DISPATCH_PER_FRAME = 4;
+	static const int MAX_IN_FLIGHT = 8;
+
+	FNavPathRequestQueue();
+
+	// Queues the query of Owner. Query.PathInstanceToFill is the path to fill and StartPoly the poly of the start
+	// location (0 if unknown). A pending request of the same owner is replaced by this one and keeps its place in the queue
+	void Enqueue(const UObject* Owner, const FNavAgentProperties& AgentProperties, const FPathFindingQuery& Query, const NavNodeRef StartPoly, const int32 Priority);
+	// Drops the pending request of Owner, and the result of its request in flight is not told to anyone
+	void Cancel(const UObject* Owner);
+	// Dispatches the highest priority requests within the frame budget
+	void Process(UNavigationSystem* NavSys);
+
+	int32 GetNumPending() const;
+	int32 GetNumInFlight() const;
+	int32 GetNumCoalesced() const;
+
+	// Start poly the query was queued with, 0 if it was not dispatched by this queue. Any thread
+	NavNodeRef GetDispatchedStartPoly(const FPathFindingQuery& Query) const;
+
+	FOnQueuedPathFound OnQueuedPathFound;
+
+private:
+	struct FQueuedPathRequest {
+		TWeakObjectPtr<const UObject> Owner;
+		FNavAgentProperties AgentProperties;
+		FPathFindingQuery Query;
+		NavNodeRef StartPoly;
+		int32 Priority;
+		// Enqueue order, older first in the same priority
+		uint32 Order;
+
+		FQueuedPathRequest(const UObject* Owner, const FNavAgentProperties& AgentProperties, const FPathFindingQuery& Query, const NavNodeRef StartPoly, const int32 Priority, const uint32 Order)
+			: Owner(Owner), AgentProperties(AgentProperties), Query(Query), StartPoly(StartPoly), Priority(Priority), Order(Order) {}
+	};
+
+	struct FDispatchedPathRequest {
+		// Invalid once cancelled
+		TWeakObjectPtr<const UObject> Owner;
+		const FNavigationPath* Path;
+		NavNodeRef StartPoly;
+
+		FDispatchedPathRequest(const TWeakObjectPtr<const UObject>& Owner, const FNavigationPath* Path, const NavNodeRef StartPoly)
+			: Owner(Owner), Path(Path), StartPoly(StartPoly) {}
+	};
+
+	TArray<FQueuedPathRequest> Pending;
+	// Requests in flight, read by the workers
+	TArray<FDispatchedPathRequest> Dispatched;
+	mutable FCriticalSection DispatchedLock;
+	int32 NumCoalesced;
+	uint32 NextOrder;
+
+	void OnPathFound(uint32 QueryID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+};
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "AI/Navigation/RecastNavMesh.h"
+
+/**
+ * Poly under a moving agent. Agents move a little between lookups, so the previous poly and its neighbours
+ * are tested first (point in poly and height), and the box query on the navmesh is only done when the
+ * agent left them (teleport, fall, first lookup).
+ */
+class SHOOTERGAME_API FNavPolyTracker
+{
+public:
+	// Extent of the spatial query when the agent is not around its previous poly
+	static const int QUERY_EXTENT_XY = 100;
+	static const int QUERY_EXTENT_Z = 300;
+	// Max distance between the location and the poly surface to be on the poly
+	static const int MAX_HEIGHT_DIFF = 100;
+
+	FNavPolyTracker();
+
+	// Location on the navmesh under Location, tracked from the previous update. False if it is off the navmesh
+	bool Update(const ARecastNavMesh* NavMesh, const FVector Location, FNavLocation& OutNavLocation);
+	// Only tests the current poly and its neighbours, without the spatial query nor updating the tracker
+	bool FindNearby(const ARecastNavMesh* NavMesh, const FVector Location, FNavLocation& OutNavLocation) const;
+	void Reset();
+
+	NavNodeRef GetCurrentPoly() const;
+	// Updates answered without the spatial query
+	int32 GetNumCoherentHits() const;
+	int32 GetNumSpatialQueries() const;
+
+private:
+	NavNodeRef CurrentPoly;
+	int32 NumCoherentHits;
+	int32 NumSpatialQueries;
+
+	// Height of the poly under Location (its triangle fan), false if Location is not above it
+	static bool GetPolyHeight(const dtMeshTile* Tile, const dtPoly* Poly, const FVector Location, float& OutHeight);
+};
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Runtime/Navmesh/Public/Detour/DetourNavMesh.h"
+
+/**
+ * Cooked navmesh tiles of a map in one binary file: a header with the navmesh params, the table of tiles
+ * and the detour data of each tile starting at a page boundary. Generated by UBakeNavTilesCommandlet into
+ * Content/NavTiles/<MapName>.navtiles (staged as a loose file, it is mapped from disk).
+ * The file is memory mapped copy on write: detour tile data has no pointers, addTile points the tile into
+ * the mapped pages and only the pages detour writes (links, areas) become private to the process, so the
+ * servers of the same map share the rest through the page cache.
+ */
+class SHOOTERGAME_API FNavTileBlob
+{
+public:
+	static const uint32 MAGIC = 0x4254564E; // NVTB
+	static const uint32 VERSION = 1;
+	// Tiles start at this alignment in the file
+	static const int PAGE_SIZE = 4096;
+	static const FString FILE_EXTENSION;
+
+	~FNavTileBlob();
+
+	// NULL if there is no file or it is not valid for this build
+	static TSharedPtr<FNavTileBlob> Map(const FString& FileName);
+	// Writes every tile of the navmesh
+	static bool Write(const FString& FileName, const dtNavMesh* DetourMesh);
+	static FString GetFileName(UWorld * World);
+
+	// The tiles were generated with the same layout (origin, tile size, max tiles and polys)
+	bool MatchesParams(const dtNavMeshParams& Params) const;
+	int32 GetNumTiles() const;
+	unsigned char* GetTileData(const int32 Index) const;
+	int32 GetTileDataSize(const int32 Index) const;
+	// False when the platform could not map it and the file was read in memory instead
+	bool IsMapped() const;
+
+private:
+	struct FBlobHeader {
+		uint32 Magic;
+		uint32 Version;
+		uint32 DetourVersion;
+		int32 NumTiles;
+		dtNavMeshParams Params;
+	};
+
+	struct FBlobTile {
+		uint64 Offset;
+		int32 Size;
+		int32 Padding;
+	};
+
+	uint8* Data;
+	int64 Size;
+	bool bMapped;
+	// Windows file and mapping handles
+	void* FileHandle;
+	void* MappingHandle;
+
+	FNavTileBlob();
+	const FBlobHeader& GetHeader() const;
+	const FBlobTile& GetTile(const int32 Index) const;
+	bool IsValid() const;
+};
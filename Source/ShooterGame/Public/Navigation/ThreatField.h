@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Runtime/Navmesh/Public/Detour/DetourNavMesh.h"
+#include "Public/Others/VisibilityFan.h"
+
+/**
+ * Immutable threat of the navmesh for one version of the player visibility.
+ * Navigation filters capture one when the query is created and only read that one,
+ * so path queries can run on any thread while the game thread publishes new versions.
+ */
+class SHOOTERGAME_API FThreatField
+{
+public:
+	FThreatField(const uint32 Version, const TSharedPtr<const FVisibilityFan, ESPMode::ThreadSafe>& PlayerVisibility);
+
+	const uint32 Version;
+	// NULL if nobody sees the player
+	const TSharedPtr<const FVisibilityFan, ESPMode::ThreadSafe> PlayerVisibility;
+
+	bool IsPointVisible(const FVector2D Point) const;
+	// False only if nothing inside the bounds can be seen by the player
+	bool MayBeVisible(const FBox2D& Bounds) const;
+	// Length of the segment seen by the player
+	float GetExposedLength(const FVector2D Start, const FVector2D End) const;
+	// Fraction of the poly seen by the player, computed the first time a poly is asked for. Thread safe
+	float GetPolyVisibleFraction(const dtPolyRef PolyRef, const dtMeshTile* Tile, const dtPoly* Poly) const;
+
+private:
+	mutable FCriticalSection PolyThreatsLock;
+	mutable TMap<dtPolyRef, float> PolyThreats;
+
+	static float ComputePolyVisibleFraction(const FVisibilityFan& Fan, const dtMeshTile* Tile, const dtPoly* Poly);
+};
+
+typedef TSharedPtr<const FThreatField, ESPMode::ThreadSafe> FThreatFieldPtr;
+
+/**
+ * Owner of the latest threat field of a world. Published on the game thread, read from any thread
+ */
+class SHOOTERGAME_API FThreatFieldPublisher
+{
+public:
+	FThreatFieldPublisher();
+
+	void Publish(const TSharedPtr<const FVisibilityFan, ESPMode::ThreadSafe>& PlayerVisibility);
+	FThreatFieldPtr GetLatest() const;
+
+private:
+	mutable FCriticalSection LatestLock;
+	FThreatFieldPtr Latest;
+	uint32 NextVersion;
+};
+
+typedef TSharedPtr<FThreatFieldPublisher, ESPMode::ThreadSafe> FThreatFieldPublisherPtr;
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CellVisibilityData.generated.h"
+
+/**
+ * Baked cell to cell visibility of the static geometry at eyes height (HelperMethods::EYES_POS_Z).
+ * Only navigable cells get a row. Rows are stored as run lengths of alternating not visible/visible cells
+ * and expanded to a bit matrix on load so queries are O(1).
+ * Generated by UBakeCellVisibilityCommandlet and saved next to the map as <MapName>_Visibility
+ */
+UCLASS()
+class SHOOTERGAME_API UCellVisibilityData : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	static const FString ASSET_SUFFIX;
+
+	UPROPERTY()
+	FVector2D GridOrigin;
+	UPROPERTY()
+	float CellSize;
+	UPROPERTY()
+	int32 CellsX;
+	UPROPERTY()
+	int32 CellsY;
+
+	// Row of each cell of the grid (-1 if the cell is not navigable)
+	UPROPERTY()
+	TArray<int32> CellRows;
+	// Index of the first run of each row in Runs. Has one extra element with the total number of runs
+	UPROPERTY()
+	TArray<int32> RowOffsets;
+	// Run lengths of every row, starting with a not visible run (that can be 0)
+	UPROPERTY()
+	TArray<uint16> Runs;
+
+public:
+	static UCellVisibilityData* LoadForWorld(UWorld * World);
+	static FString GetAssetPath(UWorld * World);
+
+	virtual void PostLoad() override;
+
+	int32 GetCellIndex(const FVector Location) const;
+	int32 GetRow(const FVector Location) const;
+	int32 GetNumRows() const;
+
+	// Returns false if any of the locations is not inside a baked cell. Otherwise OutVisible is the static visibility between them
+	bool GetVisibility(const FVector From, const FVector To, bool &OutVisible) const;
+
+	// Encodes the visibility matrix (NumRows x NumRows bits) as run length rows
+	void SetVisibility(const TBitArray<> &VisibilityMatrix, const int32 NumRows);
+
+private:
+	// Expanded visibility matrix, NumRows * NumRows
+	TBitArray<> VisibilityBits;
+	int32 NumRows;
+
+	void ExpandRuns();
+};
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Uniform grid of the cover annotations (actors attached to the ACoverBaseClass actors), built on BeginPlay.
+ * The annotations are sorted by cell and each cell keeps the range of its annotations, so radius and
+ * k nearest queries only visit the cells around the location and do not allocate (the caller keeps the
+ * output array). Covers spawned after the build are not in it.
+ */
+class SHOOTERGAME_API FCoverAnnotationIndex
+{
+public:
+	static const int CELL_SIZE = 500;
+	static const int MAX_NEAREST = 8;
+
+	struct FCoverAnnotation {
+		FVector Location;
+		// Location of the cover actor the annotation is attached to
+		FVector CoverLocation;
+	};
+
+	FCoverAnnotationIndex();
+
+	void Build(UWorld * World);
+
+	int32 Num() const;
+	const FCoverAnnotation& GetAnnotation(const int32 Index) const;
+
+	// Annotations within Radius of Location, in no particular order
+	void FindInRadius(const FVector Location, const float Radius, TArray<int32> &OutAnnotations) const;
+	// Closest annotation within MaxDistance (INDEX_NONE if there is none)
+	int32 FindNearest(const FVector Location, const float MaxDistance) const;
+	// Up to K (at most MAX_NEAREST) closest annotations within MaxDistance, closest first
+	void FindNearest(const FVector Location, const float MaxDistance, const int32 K, TArray<int32> &OutAnnotations) const;
+
+private:
+	FVector2D Origin;
+	int32 CellsX, CellsY;
+
+	// Sorted by cell
+	TArray<FCoverAnnotation> Annotations;
+	// Index of the first annotation of each cell. Has one extra element with Annotations.Num()
+	TArray<int32> CellStarts;
+
+	int32 GetCellX(const float X) const;
+	int32 GetCellY(const float Y) const;
+};
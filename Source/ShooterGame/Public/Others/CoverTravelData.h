@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoverTravelData.generated.h"
+
+/**
+ * Baked travel times between every pair of waypoints of a map: the cover annotations (actors attached to the
+ * ACoverBaseClass actors) and a grid of navmesh points. Times are quantized to 16 bits (TimeStep seconds each,
+ * UNREACHABLE when there is no path), so the travel between two waypoints is an array read instead of a path
+ * finding. Locations are snapped to the closest waypoint within SNAP_DISTANCE.
+ * Generated by UBakeCoverTravelCommandlet and saved next to the map as <MapName>_CoverTravel
+ */
+UCLASS()
+class SHOOTERGAME_API UCoverTravelData : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	static const FString ASSET_SUFFIX;
+	static const uint16 UNREACHABLE = MAX_uint16;
+	static const int SNAP_DISTANCE = 200;
+
+	// Cover annotations first, then the navmesh points
+	UPROPERTY()
+	TArray<FVector> Waypoints;
+	UPROPERTY()
+	int32 NumCovers;
+	// Speed the path lengths were converted to times with
+	UPROPERTY()
+	float WalkSpeed;
+	UPROPERTY()
+	float TimeStep;
+	// NumWaypoints x NumWaypoints, row of the waypoint the travel starts from
+	UPROPERTY()
+	TArray<uint16> TravelTimes;
+
+public:
+	static UCoverTravelData* LoadForWorld(UWorld * World);
+	static FString GetAssetPath(UWorld * World);
+
+	virtual void PostLoad() override;
+
+	int32 GetNumWaypoints() const;
+	// Closest waypoint within SNAP_DISTANCE (INDEX_NONE if there is none)
+	int32 FindWaypoint(const FVector Location) const;
+	// BIG_NUMBER if there is no path
+	float GetTravelTime(const int32 FromWaypoint, const int32 ToWaypoint) const;
+	// Returns false if a location does not snap to a waypoint, or cannot walk straight to it on the navmesh of
+	// NavData (snapping is 3D, a waypoint close by may be behind a wall or on another floor). Otherwise OutTime is
+	// the travel time between them (BIG_NUMBER if there is no path), walking straight to and from the waypoints
+	bool GetTravelTime(const ANavigationData* NavData, const FVector From, const FVector To, float &OutTime) const;
+
+	// Quantizes the times (NumWaypoints x NumWaypoints, BIG_NUMBER if there is no path)
+	void SetTravelTimes(const TArray<float> &Times);
+
+private:
+	// Waypoints of each SNAP_DISTANCE cell
+	TMap<FIntPoint, TArray<int32>> WaypointCells;
+
+	FIntPoint GetCell(const FVector Location) const;
+	bool IsWaypointReachable(const ANavigationData* NavData, const FVector Location, const int32 Waypoint) const;
+	void BuildWaypointCells();
+};
@@ -4,6 +4,16 @@
 
 #include "Public/Navigation/MyRecastNavMesh.h"
 
+// The triangles are handed over, the delegate can move them
+DECLARE_DELEGATE_OneParam(FVisibilityCalculatedDelegate, TArray<Triangle>&);
+
+// Result of the two traces shot towards a vertex of the visibility fan
+struct VertexTraceResult {
+	bool VertexBlocked = false;
+	FVector VertexHit = FVector(0, 0, 0);
+	FVector Projected = FVector(0, 0, 0);
+};
+
 /**
  * 
  */
@@ -15,6 +25,8 @@ public:
 	static const int OFFSET = 10;
 
 	static const int EYES_POS_Z = 150;
+	// Eyes height of a crouched character (or someone peeking over low cover)
+	static const int CROUCHED_EYES_POS_Z = 90;
 
 
 	// 
@@ -36,14 +48,40 @@ public:
 	static 	FVector GetPlayerPositionFromAI(UWorld * World);
 	static 	FVector GetPlayerForwardVectorFromAI(UWorld * World);
 
+	// The projected traces of the fan reach ViewDistance (they always reached PLAYER_DV before the async mode)
 	static TArray<Triangle> CalculateVisibility(UWorld * World, const FVector Location, const FVector ForwardVector, const float ViewAngle = PLAYER_FOV, const float ViewDistance = PLAYER_DV);
+	// Same fan as CalculateVisibility but all the traces go through the async trace queue. OnCalculated is executed next frame
+	static void CalculateVisibilityAsync(UWorld * World, const FVector Location, const FVector ForwardVector, const FVisibilityCalculatedDelegate OnCalculated, const float ViewAngle = PLAYER_FOV, const float ViewDistance = PLAYER_DV);
 	
+	static AMyRecastNavMesh* GetNavMesh(UWorld * World);
+	// Team of the pawn in team games, otherwise bots are team 1 and humans team 0
+	static int32 GetTeam(const APawn * Pawn);
+
+	// Line of sight between two locations at eyes height using the baked cell visibility (UCellVisibilityData),
+	// or the occlusion height grid (built from the baked occluders) when there are no cells.
+	// Returns false when there is no bake or a location is outside the baked cells, then the caller has to trace.
+	// RefineWithDynamic traces against dynamic objects when the static geometry does not block
+	static bool GetBakedLineOfSight(UWorld * World, const FVector From, const FVector To, bool &OutVisible, const bool RefineWithDynamic = false);
+	// Line of sight between two locations with their own eyes height (i.e. standing vs crouched) using the occlusion height grid.
+	// Returns false when there is no grid
+	static bool GetStanceLineOfSight(UWorld * World, const FVector From, const float FromEyesZ, const FVector To, const float ToEyesZ, bool &OutVisible);
+	// Conservative line of sight at eyes height against the static collision (FOccupancyGrid), no traces.
+	// Only Blocked is final: Uncertain results (near some collision border, an endpoint not at eyes height, or no grid)
+	// need a trace, and Clear ones too when dynamic actors matter
+	static ELineOfSight GetGridLineOfSight(UWorld * World, const FVector From, const FVector To);
+
+	// Builds the triangles of the fan from the traces results of each sorted vertex (shared by sync and async modes)
+	static TArray<Triangle> AssembleVisibleTriangles(const TArray<Vertex> &VisibleVertexs, const TArray<VertexTraceResult> &TraceResults, const FVector EyesLocation);
+
 	//static TArray<FVector> GetLocationOfCoverAnnotationsWithinRadius(UWorld * World, const FVector ContextLocation, const float MaxRadius);
 	//static TArray<FVector> GetLocationOfAttackAnnotationsWithinRadius(UWorld * World, const FVector ContextLocation, const float MaxRadius);
 private:
 	static TArray<Vertex> GetVisibleObstaclesVertexs(UWorld * World, const FVector EyesLocation, const FVector ForwardVector, const float ViewAngle = PLAYER_FOV, const float ViewDistance = PLAYER_DV);
+	static TArray<Vertex> GetVisibleOccludersVertexs(const UOccluderSegmentData * Occluders, const FVector EyesLocation, const FVector ForwardVector, const float ViewAngle, const float ViewDistance);
 	static void SortByAngle(TArray<Vertex> &FVectorArray, const FVector EyesLocation, const FVector FirstTrace);
-	static TArray<Triangle> GetVisibleTriangles(const TArray<Vertex> VisibleVertexs, UWorld * World, const FVector EyesLocation, const float ViewAngle = PLAYER_FOV, const float ViewDistance = PLAYER_DV);
+	static TArray<Vertex> GetSortedFanVertexs(UWorld * World, const FVector EyesLocation, const FVector ForwardVector, const float ViewAngle, const float ViewDistance);
+	static TArray<Triangle> GetVisibleTriangles(const TArray<Vertex> &VisibleVertexs, UWorld * World, const FVector EyesLocation, const float ViewAngle = PLAYER_FOV, const float ViewDistance = PLAYER_DV);
+	static FCollisionQueryParams GetVisibilityTraceParams(UWorld * World);
 
 
 	FRecastQueryFilter_Example * GetCustomFilter();
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "OccluderSegmentData.generated.h"
+
+/**
+ * Baked 2D footprints of the static blocking collision of a map (boxes, spheres, capsules and convex
+ * elements, rotated as placed). Each footprint is a closed convex loop (counter clockwise) with the
+ * height range of its collision, so visibility can pick the loops that block a given eyes height.
+ * Generated by UBakeOccludersCommandlet and saved next to the map as <MapName>_Occluders
+ */
+UCLASS()
+class SHOOTERGAME_API UOccluderSegmentData : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	static const FString ASSET_SUFFIX;
+
+	// Vertexs of every loop, one after the other
+	UPROPERTY()
+	TArray<FVector2D> Points;
+	// Index of the first point of each loop in Points. Has one extra element with Points.Num()
+	UPROPERTY()
+	TArray<int32> LoopOffsets;
+	UPROPERTY()
+	TArray<FBox2D> LoopBounds;
+	UPROPERTY()
+	TArray<float> LoopMinZ;
+	UPROPERTY()
+	TArray<float> LoopMaxZ;
+
+public:
+	static UOccluderSegmentData* LoadForWorld(UWorld * World);
+	static FString GetAssetPath(UWorld * World);
+
+	void AddLoop(const TArray<FVector2D> &Loop, const float MinZ, const float MaxZ);
+
+	int32 GetNumLoops() const;
+	int32 GetLoopStart(const int32 Loop) const;
+	int32 GetLoopNum(const int32 Loop) const;
+	// Collision of the loop is between its min and max height
+	bool LoopBlocksAtHeight(const int32 Loop, const float Z) const;
+};
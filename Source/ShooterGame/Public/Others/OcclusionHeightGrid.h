@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class UOccluderSegmentData;
+
+/**
+ * 2.5D occlusion grid: each cell keeps up to MAX_LAYERS height intervals [MinZ, MaxZ] where the static
+ * collision blocks. Line of sight between any two heights (standing, crouched, over low cover) is answered
+ * by marching the cells under the segment and comparing the interpolated height with the cell layers.
+ * Built from the baked occluders (UOccluderSegmentData) when the map is loaded.
+ */
+class SHOOTERGAME_API FOcclusionHeightGrid
+{
+public:
+	static const int CELL_SIZE = 50;
+	static const int MAX_LAYERS = 2;
+
+	FOcclusionHeightGrid(const FBox2D& Bounds, const float CellSize = CELL_SIZE);
+
+	void AddOccluders(const UOccluderSegmentData * Occluders);
+	void AddBlockingInterval(const int32 Cell, const float MinZ, const float MaxZ);
+
+	// Point is inside the blocking collision of its cell
+	bool IsBlockedAt(const FVector Point) const;
+	// Top of the highest blocking layer of the cell (-BIG_NUMBER if nothing blocks)
+	float GetBlockingHeight(const FVector2D Point) const;
+
+	// The cells of the endpoints are not checked (the observer may be leaning on the cover)
+	bool IsLineOfSightBlocked(const FVector From, const FVector To) const;
+
+private:
+	FVector2D Origin;
+	float CellSize;
+	int32 CellsX, CellsY;
+
+	// MAX_LAYERS intervals per cell, an empty layer has MinZ > MaxZ
+	TArray<float> LayerMinZ;
+	TArray<float> LayerMaxZ;
+
+	int32 GetCellIndex(const FVector2D Point) const;
+	bool CellBlocksAtHeight(const int32 Cell, const float Z) const;
+};
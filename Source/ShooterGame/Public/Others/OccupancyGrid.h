@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class UOccluderSegmentData;
+
+enum class ELineOfSight : uint8
+{
+	Blocked,
+	Clear,
+	// Close to the border of some collision (or outside the grid): only a trace can tell
+	Uncertain
+};
+
+/**
+ * Occupancy of the static collision at one height, built from the baked occluders. A cell is full if the
+ * collision covers it completely and partial if it only covers some of it. Line of sight walks the cells
+ * crossed by the segment (Amanatides-Woo), so it is conservative: full cells block, partial cells make it uncertain.
+ */
+class SHOOTERGAME_API FOccupancyGrid
+{
+public:
+	static const int CELL_SIZE = 50;
+
+	static const uint8 CELL_EMPTY = 0;
+	static const uint8 CELL_PARTIAL = 1;
+	static const uint8 CELL_FULL = 2;
+
+	FOccupancyGrid(const FBox2D& Bounds, const float Height, const float CellSize = CELL_SIZE);
+
+	void AddOccluders(const UOccluderSegmentData * Occluders);
+
+	float GetHeight() const;
+	uint8 GetCellState(const FVector2D Point) const;
+
+	// The cells of the endpoints are not checked (the observer may be leaning on the cover)
+	ELineOfSight GetLineOfSight(const FVector2D From, const FVector2D To) const;
+	// Same origin, many targets
+	void GetLineOfSight(const FVector2D From, const TArray<FVector2D> &To, TArray<ELineOfSight> &OutLineOfSight) const;
+
+private:
+	FVector2D Origin;
+	float CellSize;
+	float Height;
+	int32 CellsX, CellsY;
+
+	TArray<uint8> Cells;
+
+	void MarkCell(const int32 CellX, const int32 CellY, const uint8 State);
+};
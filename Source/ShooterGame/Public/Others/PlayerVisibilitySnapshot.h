@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Public/Navigation/MyRecastNavMesh.h"
+#include "Public/Others/VisibilityFan.h"
+
+/**
+ * Visibility fan of one human player for one perception update. Immutable once published,
+ * bots, navigation filters and EQS tests share the same instance.
+ */
+class SHOOTERGAME_API FPlayerVisibilitySnapshot
+{
+public:
+	// Takes the triangles over, the fan is built once and shared by reference
+	FPlayerVisibilitySnapshot(const FVector Location, const FVector ForwardVector, TArray<Triangle>&& Triangles);
+
+	const FVector Location;
+	const FVector ForwardVector;
+	const TArray<Triangle> Triangles;
+	const FVisibilityFanRef Fan;
+	// GFrameCounter when it was published
+	const uint64 Frame;
+};
+
+typedef TSharedPtr<const FPlayerVisibilitySnapshot, ESPMode::ThreadSafe> FPlayerVisibilitySnapshotPtr;
+
+/**
+ * Perception stage: computes each human visibility at most once per frame, no matter how many bots ask for it
+ */
+class SHOOTERGAME_API PlayerVisibilitySnapshots
+{
+public:
+	// First request of the frame computes the fan (sync or async), the rest just share it
+	static void Request(UWorld * World, APawn * Player, const bool Async);
+	// Player is not seen by the requester. Snapshot is dropped only if nobody asked for it since last frame
+	static void Release(UWorld * World, const APawn * Player);
+
+	// Latest snapshot of Player (of any player if NULL). Invalid if there is none
+	static FPlayerVisibilitySnapshotPtr Get(UWorld * World, const APawn * Player = NULL);
+
+private:
+	static void Publish(UWorld * World, const APawn * Player, FPlayerVisibilitySnapshotPtr Snapshot);
+	// The navmesh threat field follows the latest snapshot of any player
+	static void PublishThreatField(UWorld * World);
+	static void OnAsyncCalculated(TArray<Triangle>& VisibleTriangles, TWeakObjectPtr<APawn> Player, FVector Location, FVector ForwardVector);
+};
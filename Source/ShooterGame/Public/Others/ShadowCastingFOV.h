@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+ * Symmetric shadow casting field of view over a grid of opaque/transparent cells.
+ * Each of the four quadrants is scanned row by row, splitting the visible slopes whenever an opaque cell is found,
+ * so only the visible cells (and the opaque cells bounding them) are touched.
+ * A cell is visible from the origin if and only if the origin is visible from it.
+ */
+class SHOOTERGAME_API FShadowCastingFOV
+{
+public:
+	FShadowCastingFOV();
+
+	// Opaque has one bit per cell, row major (CellsX * CellsY)
+	void Initialize(const TBitArray<> &Opaque, const int32 CellsX, const int32 CellsY);
+
+	bool IsOpaque(const int32 X, const int32 Y) const;
+
+	// Indexes (Y * CellsX + X) of the cells visible from the origin cell inside the view cone and the range.
+	// ViewAngle is half the cone in degrees and Range is measured in cells
+	void GetVisibleCells(const int32 OriginX, const int32 OriginY, const FVector2D ForwardVector, const float ViewAngle, const float Range, TArray<int32> &OutVisibleCells) const;
+
+private:
+	struct FScan {
+		int32 OriginX, OriginY;
+		int32 Quadrant;
+		FVector2D Forward;
+		float CosViewAngle;
+		float Range;
+		TArray<int32>* VisibleCells;
+	};
+
+	TBitArray<> Opaque;
+	int32 CellsX, CellsY;
+
+	void ScanRow(const FScan &Scan, const int32 Depth, float StartSlope, const float EndSlope) const;
+	void RevealCell(const FScan &Scan, const int32 X, const int32 Y) const;
+	void GetCell(const FScan &Scan, const int32 Depth, const int32 Column, int32 &OutX, int32 &OutY) const;
+};
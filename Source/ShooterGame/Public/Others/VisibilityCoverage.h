@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Public/Others/VisibilityFan.h"
+
+/**
+ * Union of the visibility fans of several observers rasterized on a 2D grid. Each cell counts how many
+ * observers see it, so the queries cost the same no matter how many observers there are.
+ * Updating an observer only touches the cells it stopped seeing and the ones it started seeing.
+ */
+class SHOOTERGAME_API FVisibilityCoverageGrid
+{
+public:
+	static const int CELL_SIZE = 100;
+
+	FVisibilityCoverageGrid(const FBox2D& Bounds, const float CellSize = CELL_SIZE);
+
+	void UpdateObserver(const AActor * Observer, const FVisibilityFan& Fan);
+	void RemoveObserver(const AActor * Observer);
+	int32 GetNumObservers() const;
+
+	// How many observers see the point (0 if outside the grid)
+	int32 GetCoverageCount(const FVector2D Point) const;
+	bool IsPointCovered(const FVector2D Point) const;
+
+	// Fraction [0, 1] of the segment seen by at least one observer (sampled every half cell)
+	float GetSegmentCoverage(const FVector2D From, const FVector2D To) const;
+	bool IsSegmentCovered(const FVector2D From, const FVector2D To) const;
+
+private:
+	FVector2D Origin;
+	float CellSize;
+	int32 CellsX, CellsY;
+
+	TArray<uint8> Counts;
+	TMap<TWeakObjectPtr<const AActor>, TArray<int32>> ObserverCells;
+
+	int32 GetCellIndex(const FVector2D Point) const;
+	FVector2D GetCellCenter(const int32 CellX, const int32 CellY) const;
+	void Rasterize(const FVisibilityFan& Fan, TArray<int32>& OutCells) const;
+	void AddCell(const int32 Cell, const int32 Delta);
+	void AddCells(const TArray<int32>& Cells, const int32 Delta);
+	void RemoveStaleObservers();
+};
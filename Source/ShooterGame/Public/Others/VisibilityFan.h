@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+class Triangle;
+
+/**
+ * Precompiled visibility fan (triangles from HelperMethods::CalculateVisibility, V2 is always the eyes).
+ * Triangles are stored in SoA form with their edge equations, so point tests don't need divisions:
+ *  - IsPointInside does an angular lookup around the eyes and one edge test (far edge of the sector)
+ *  - ArePointsInside tests 4 points per step against all the triangles with SIMD
+ */
+class SHOOTERGAME_API FVisibilityFan
+{
+public:
+	FVisibilityFan();
+	explicit FVisibilityFan(const TArray<Triangle>& Triangles);
+
+	void Build(const TArray<Triangle>& Triangles);
+
+	// Builds the fan once to share it between its readers
+	static TSharedRef<const FVisibilityFan, ESPMode::ThreadSafe> Create(const TArray<Triangle>& Triangles);
+
+	bool IsEmpty() const;
+	int32 Num() const;
+	const FBox2D& GetBounds() const;
+	FVector2D GetEyes() const;
+
+	bool IsPointInside(const FVector2D Point) const;
+
+	// Returns how many points are inside. OutInside must have room for Count elements
+	int32 ArePointsInside(const FVector2D* Points, const int32 Count, bool* OutInside) const;
+	int32 ArePointsInside(const TArray<FVector2D>& Points, TArray<bool>& OutInside) const;
+
+	// Exact length of the segment inside the fan (the segment is clipped against the triangles, 4 at a time)
+	float GetSegmentLengthInside(const FVector2D Start, const FVector2D End) const;
+
+private:
+	static const int32 NUM_ANGULAR_BINS = 64;
+
+	FVector2D Eyes;
+	FBox2D Bounds;
+
+	// Edge K of triangle T is EdgeA[K][T] * X + EdgeB[K][T] * Y + EdgeC[K][T], >= 0 means inner side. Edge 2 is the far edge (V3, V1)
+	TArray<float> EdgeA[3];
+	TArray<float> EdgeB[3];
+	TArray<float> EdgeC[3];
+
+	// Angular index. Sectors are in pseudo angle units relative to StartDirection
+	FVector2D StartDirection;
+	float AngleSign;
+	TArray<float> SectorStart;
+	TArray<float> SectorEnd;
+	// First and last sector that overlap each bin (INDEX_NONE if none)
+	TArray<int32> BinFirstSector;
+	TArray<int32> BinLastSector;
+	float MaxAngle;
+	// False if the sectors overlap or the fan is wider than 180 degrees. Then IsPointInside scans all the triangles
+	bool HasAngularIndex;
+
+	float GetPseudoAngle(const FVector2D Point) const;
+	float GetEdgeValue(const int32 Edge, const int32 Index, const FVector2D Point) const;
+	bool IsInsideTriangle(const int32 Index, const FVector2D Point) const;
+	void BuildAngularIndex(const TArray<FVector2D>& FirstBoundary, const TArray<FVector2D>& LastBoundary);
+};
+
+typedef TSharedRef<const FVisibilityFan, ESPMode::ThreadSafe> FVisibilityFanRef;
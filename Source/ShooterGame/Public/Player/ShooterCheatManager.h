@@ -29,4 +29,8 @@ class UShooterCheatManager : public UCheatManager
 
 	UFUNCTION(exec)
 	void SpawnBot();
+
+	/** Spawns Count bots, i.e. to profile the crowd with "stat AICrowd" */
+	UFUNCTION(exec)
+	void SpawnBots(int32 Count);
 };